@@ -16,10 +16,20 @@
  * - Pietro Zanaga Neto - 10418574
  */
 
+#include <ctype.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+/* Com -DUSA_PTHREAD (e -pthread) as linhas da matriz de paradas e as rotas
+   de cada veiculo sao calculadas em paralelo, com uma thread por nucleo; sem
+   a flag o programa continua ANSI C puro. */
+#ifdef USA_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 #define MAX_CHARS 51
 
@@ -28,6 +38,30 @@
 #define CINZA  1
 #define PRETO  2
 
+/* Acima deste numero de localidades o main usa branch and bound em vez da forca bruta */
+#define LIMITE_FORCA_BRUTA 8
+
+/* Ate este numero de paradas o modo com janelas de tempo e exato; acima, heuristico */
+#define LIMITE_EXATO_JANELAS 12
+
+/* Ate este numero de paradas a rota de um veiculo e otimizada por branch and bound */
+#define LIMITE_EXATO_VEICULO 12
+
+/* Indice de busca de localidades: trigramas sobre o alfabeto normalizado
+   (espaco, a-z, 0-9) e limites da busca aproximada */
+#define TAM_ALFABETO_TRIGRAMA 37
+#define NUM_TRIGRAMAS (TAM_ALFABETO_TRIGRAMA * TAM_ALFABETO_TRIGRAMA * TAM_ALFABETO_TRIGRAMA)
+#define LIMITE_LEITURA_FUZZY 20000 /* entradas de listas lidas por consulta */
+#define MAX_PRE_CANDIDATOS 512     /* candidatos recontados sobre todos os trigramas da consulta */
+#define MAX_CANDIDATOS_FUZZY 64    /* candidatos reavaliados por distancia de edicao */
+#define SIMILARIDADE_MINIMA 0.4    /* aceita a correcao automatica a partir deste valor */
+
+/* Rotas alternativas: candidatos de Yen examinados para cada rota aceita */
+#define CANDIDATOS_POR_ALTERNATIVA 20
+
+/* Acesso a matriz de distancias entre paradas (vetor linear n x n) */
+#define DIST(m, n, i, j) ((m)[(i) * (n) + (j)])
+
 
 enum letras {
     A=65,B,C,D,E,F,G,H,I,J,K,L,M,N,O,P,Q,R,S,T,U,V,W,X,Y,Z
@@ -42,6 +76,106 @@ typedef struct {
 	int distancia_v;
 }Localidade;
 
+/* Restricoes de atendimento de uma localidade no modo com janelas de tempo.
+   Horarios em minutos a partir de 00:00. */
+typedef struct {
+	char nome[MAX_CHARS];
+	int abertura;   /* horario de abertura (chegadas antes disso esperam) */
+	int fechamento; /* ultimo horario de chegada aceito */
+	int servico;    /* duracao do atendimento em minutos */
+	int demanda;    /* carga ocupada no veiculo por esta parada */
+} AtributosLocalidade;
+
+/* Parametros do passeio com restricoes: saida e volta para "Minha Casa" */
+typedef struct {
+	int saida;      /* horario de saida de casa */
+	int retorno;    /* horario limite de chegada em casa */
+	int capacidade; /* soma maxima das demandas atendidas */
+	int velocidade; /* metros por minuto */
+} RestricoesRota;
+
+/* Rota fechada de um veiculo no modo com varios veiculos: paradas sao indices
+   da matriz de paradas (1..n-1), todas saindo e voltando para a casa (0). */
+typedef struct {
+	int *paradas;
+	int nParadas;
+	int custo;
+} RotaVeiculo;
+
+/* No da trie de nomes normalizados (filhos em lista ordenada de irmaos) */
+typedef struct {
+	char c;
+	int filho;
+	int irmao;
+	int nome; /* indice do nome que termina neste no ou -1 */
+} NoTrie;
+
+/* Contador de trigramas em comum de um nome, zerado sob demanda: so vale
+   quando marca e a consulta corrente (um unico acesso a memoria por nome) */
+typedef struct {
+	int marca;
+	int comuns;
+} ContagemNome;
+
+/* Indice de busca de localidades: trie para busca exata e por prefixo e
+   listas invertidas de trigramas para busca aproximada. */
+typedef struct {
+	char **nomes;     /* nomes originais, como aparecem no grafo */
+	int nNomes, capNomes;
+	NoTrie *nos;      /* nos[0] e a raiz */
+	int nNos, capNos;
+	int **listas;     /* listas[trigrama] = nomes que contem o trigrama */
+	int *tamLista, *capLista;
+	ContagemNome *contagem; /* trigramas em comum na consulta corrente */
+	int *tocados;     /* nomes com contagem > 0 na consulta corrente */
+	int capTocados;
+	int consulta;
+	unsigned char *posConsulta; /* posConsulta[trigrama] = posicao + 1 na consulta corrente, 0 se ausente */
+} IndiceLocalidades;
+
+/* Resultado da busca aproximada */
+typedef struct {
+	int nome;
+	int edicao;          /* distancia de edicao entre os nomes normalizados */
+	double similaridade; /* coeficiente de Dice sobre os trigramas */
+} CandidatoLocalidade;
+
+/* Localidade no grafo compacto: guardada uma unica vez por aresta */
+typedef struct {
+	char *nome; /* aponta para o bloco de nomes do grafo compacto */
+	int v1, v2; /* extremos da aresta */
+	int d1, d2; /* distancia da localidade a v1 e a v2 */
+} LocalidadeCompacta;
+
+/* Representacao compacta e somente leitura do grafo (CSR): vizinhos de cada
+   vertice ordenados e gravados como varint (o primeiro em zigzag relativo ao
+   proprio vertice, os demais como diferenca para o anterior) e distancias em
+   16 bits quando a maior dist_prox cabe. O estado das consultas (dist, pai,
+   cor) fica em vetores do chamador e nao no grafo. */
+typedef struct {
+	int ordem;
+	int nArestas;               /* semi-arestas (cada aresta nao orientada conta 2) */
+	unsigned int *inicio;       /* inicio[v]: byte do primeiro vizinho de v; ordem+1 entradas */
+	unsigned int *primeira;     /* primeira[v]: indice do peso da primeira aresta de v; ordem+1 entradas */
+	unsigned char *vizinhos;
+	unsigned short *peso16;     /* usado quando todas as distancias cabem em 16 bits */
+	unsigned int *peso32;       /* caso contrario */
+	LocalidadeCompacta *localidades;
+	int nLocalidades;
+	char *nomes;
+	size_t bytesNomes;
+} GrafoCompacto;
+
+/* Caminho entre duas localidades nos k caminhos mais curtos. Os vertices
+   ordem (origem) e ordem+1 (destino) sao virtuais: as localidades ficam no
+   meio de arestas e se ligam aos extremos delas. */
+typedef struct {
+	int *v;     /* vertices, de v[0] = origem ate v[n-1] = destino */
+	int *acum;  /* acum[i] = distancia da origem ate v[i] */
+	int n;
+	int custo;
+} Caminho;
+
 /* Celula da lista de adjacencia (aresta) */
 typedef struct Aresta{
 	int extremo2;
@@ -65,6 +199,8 @@ void destroiGrafo(Vert **G, int ordem);
 int  acrescentaAresta(Vert G[], int ordem, int v1, int v2, int dist_prox, char *localidade, int distancia_v1, int distancia_v2);
 void imprimeGrafo(Vert G[], int ordem);
 void constroiGrafo(Vert **G, int *ordem);
+void imprimeRota(Vert G[], int ordem, char *lugares[], int nLugares, int visita[], int distanciaMin);
+int  dijkstra(Vert G[], int ordem, char *origem, char *destino);
 
 /* Cria vetor de vertices e inicializa listas de adjacencia */
 void criaGrafo(Vert **G, int ordem){
@@ -168,7 +304,7 @@ void imprimeGrafo(Vert G[], int ordem){
 		printf("\n v%d:\n", G[i].id);
 		aux = G[i].prim;
 		for(; aux != NULL; aux = aux->prox){ /*itera sobre as arestas do vertice*/
-			printf("   -> v%d: dist=%d", aux->extremo2, aux->dist_prox);
+			printf("   -> v%d: dist=%d", G[aux->extremo2].id, aux->dist_prox);
 			if (aux->localidade.nome[0] != '\0'){
 				printf("\n     [Local: %s, dist_v=%dm]",
 					   aux->localidade.nome,
@@ -411,12 +547,12 @@ void geraPermutacoes(char vetor[], int inicio, int fim, char rotas[][26], int *i
 
 
 
-void melhorRota(Vert G[], int ordem, char *lugares[], int nLugares){
+/*Forca bruta: avalia todas as permutacoes das localidades. Preenche visita[]
+  com os indices de lugares[] na ordem da melhor rota e retorna sua distancia*/
+int rotaForcaBruta(Vert G[], int ordem, char *lugares[], int nLugares, int visita[]){
     int distancias[nLugares][nLugares];
     int distanciaMin = INT_MAX;
     int temp;
-    int verticeDestino1;
-    int verticeDestino2;
 
     char rotaAtual[26];
     char melhorRota[26];
@@ -428,6 +564,7 @@ void melhorRota(Vert G[], int ordem, char *lugares[], int nLugares){
     for(int i = 0; i < nLugares; i++){
         rotaAtual[i] = 'A' + i;
     }
+    rotaAtual[nLugares] = '\0';
 
     /*gera as permutações de rotas e as armazena em rotas*/
     geraPermutacoes(rotaAtual, 0, nLugares - 1, rotas, &indice);
@@ -475,11 +612,34 @@ void melhorRota(Vert G[], int ordem, char *lugares[], int nLugares){
         }
     }
 
+    /*Converte a melhor rota para indices das localidades*/
+    for(int i = 0; i < nLugares; i++){
+        visita[i] = melhorRota[i] - 'A';
+    }
+    return distanciaMin;
+}
+
+void melhorRota(Vert G[], int ordem, char *lugares[], int nLugares){
+    int visita[nLugares];
+    int distanciaMin = rotaForcaBruta(G, ordem, lugares, nLugares, visita);
+
+    imprimeRota(G, ordem, lugares, nLugares, visita, distanciaMin);
+}
+
+
+/*Imprime a rota fechada a partir de "Minha Casa": ordem dos locais, trajeto
+  (vertices) de cada perna e distancias. visita[] contem os indices de lugares[]
+  na ordem do passeio*/
+void imprimeRota(Vert G[], int ordem, char *lugares[], int nLugares, int visita[], int distanciaMin){
+    int temp;
+    int verticeDestino1;
+    int verticeDestino2;
+
 	/*Imprime caminho gerado pelo algoritmo*/
     printf("Ordem dos locais visitados\n");
     printf("Localidade : Casa\n");
     for(int i = 0;i<nLugares;i++){
-        printf("Localidade : %s\n",lugares[melhorRota[i]-'A']);
+        printf("Localidade : %s\n",lugares[visita[i]]);
     }
     printf("Localidade : Casa\n");
     printf("Distancia Total  = %dm\n", distanciaMin);
@@ -488,8 +648,8 @@ void melhorRota(Vert G[], int ordem, char *lugares[], int nLugares){
 
 
     /*casa ate 1 ponto*/
-    temp = dijkstra(G,ordem,lugares[melhorRota[0]-'A'],"Minha Casa");
-    printf("Trajeto: Casa ate %s\n",lugares[melhorRota[0]-'A'] );
+    temp = dijkstra(G,ordem,lugares[visita[0]],"Minha Casa");
+    printf("Trajeto: Casa ate %s\n",lugares[visita[0]] );
     Aresta *aux;
     for(int i = 0; i < ordem; i++){
 		aux = G[i].prim;
@@ -511,12 +671,12 @@ void melhorRota(Vert G[], int ordem, char *lugares[], int nLugares){
 
 
     for(int j = 0;j<nLugares-1;j++){
-        temp = dijkstra(G,ordem,lugares[melhorRota[j+1]-'A'],lugares[melhorRota[j]-'A']);
-        printf("Trajeto: %s ate %s\n",lugares[melhorRota[j]-'A'],lugares[melhorRota[j+1]-'A']);
+        temp = dijkstra(G,ordem,lugares[visita[j+1]],lugares[visita[j]]);
+        printf("Trajeto: %s ate %s\n",lugares[visita[j]],lugares[visita[j+1]]);
         for(int i = 0; i < ordem; i++){
             aux = G[i].prim;
             for(; aux != NULL; aux = aux->prox){
-                if (strcmp(aux->localidade.nome,lugares[melhorRota[j]-'A'] )==0){
+                if (strcmp(aux->localidade.nome,lugares[visita[j]] )==0){
                 verticeDestino1= i;
                 verticeDestino2= aux->extremo2;
                 }
@@ -537,13 +697,13 @@ void melhorRota(Vert G[], int ordem, char *lugares[], int nLugares){
 
     /*ultimo ponto ate casa*/
 
-    temp = dijkstra(G, ordem,"Minha Casa",lugares[melhorRota[nLugares-1]-'A']);
-    printf("Trajeto: %s ate Minha casa\n",lugares[melhorRota[nLugares-1]-'A']);
+    temp = dijkstra(G, ordem,"Minha Casa",lugares[visita[nLugares-1]]);
+    printf("Trajeto: %s ate Minha casa\n",lugares[visita[nLugares-1]]);
     for(int i = 0; i < ordem; i++){
 		aux = G[i].prim;
 		for(; aux != NULL; aux = aux->prox){
 
-			if (strcmp(aux->localidade.nome,lugares[melhorRota[nLugares-1]-'A'] )==0){
+			if (strcmp(aux->localidade.nome,lugares[visita[nLugares-1]] )==0){
                 verticeDestino1= i;
                 verticeDestino2= aux->extremo2;
 
@@ -557,21 +717,2792 @@ void melhorRota(Vert G[], int ordem, char *lugares[], int nLugares){
 	imprimeCaminho(G,verticeDestino2);
 	}
     printf("Distancia do trajeto %dm\n",temp);
+}
 
+/*Localiza a aresta que contem a localidade, da mesma forma que dijkstra().
+  Preenche os extremos da aresta e a distancia da localidade a cada um.
+  Retorna a celula da aresta na lista de *v1, ou NULL se a localidade nao
+  foi encontrada*/
+Aresta *localizaLocalidade(Vert G[], int ordem, char *nome, int *v1, int *v2, int *d1, int *d2){
+    Aresta *encontrada = NULL;
+    Aresta *aux;
+
+    for(int i = 1; i < ordem; i++){
+        for(aux = G[i].prim; aux != NULL; aux = aux->prox){
+            if (strcmp(aux->localidade.nome, nome)==0){
+                *v1 = i;
+                *v2 = aux->extremo2;
+                *d1 = aux->localidade.distancia_v;
+                *d2 = aux->dist_prox - aux->localidade.distancia_v;
+                encontrada = aux;
+            }
+        }
+    }
+    return encontrada;
+}
 
+/* Fila de tarefas independentes 0..nTarefas-1 repartida entre threads */
+typedef struct {
+	void (*tarefa)(void *arg, int i);
+	void *arg;
+	int nTarefas;
+	int proxima;          /* proxima tarefa ainda nao iniciada */
+#ifdef USA_PTHREAD
+	pthread_mutex_t trava;
+#endif
+} FilaTarefas;
+
+void *executaFilaTarefas(void *arg){
+    FilaTarefas *f = (FilaTarefas*) arg;
+    int i;
+
+    for(;;){
+#ifdef USA_PTHREAD
+        pthread_mutex_lock(&f->trava);
+#endif
+        i = f->proxima++;
+#ifdef USA_PTHREAD
+        pthread_mutex_unlock(&f->trava);
+#endif
+        if (i >= f->nTarefas) return NULL;
+        f->tarefa(f->arg, i);
+    }
 }
 
+/*Executa tarefa(arg, i) para i = 0..nTarefas-1. Com USA_PTHREAD usa no maximo
+  uma thread por nucleo disponivel (a thread chamadora e uma delas), cada uma
+  retirando da fila o proximo indice; sem a flag executa em sequencia*/
+void executaEmParalelo(int nTarefas, void (*tarefa)(void*, int), void *arg){
+    FilaTarefas f;
+
+    if (nTarefas <= 0) return;
+    f.tarefa = tarefa;
+    f.arg = arg;
+    f.nTarefas = nTarefas;
+    f.proxima = 0;
+#ifdef USA_PTHREAD
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    int nThreads = (nucleos < 1) ? 1 : (nucleos < nTarefas ? (int) nucleos : nTarefas);
+    pthread_t threads[nThreads];
+    int criadas = 0;
+
+    pthread_mutex_init(&f.trava, NULL);
+    for(int i = 1; i < nThreads; i++){
+        if (pthread_create(&threads[criadas], NULL, executaFilaTarefas, &f) == 0) criadas++;
+    }
+    executaFilaTarefas(&f); /*sem thread disponivel, a chamadora faz tudo*/
+    for(int i = 0; i < criadas; i++) pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&f.trava);
+#else
+    executaFilaTarefas(&f);
+#endif
+}
 
-int main(){
-	Vert *G = NULL;
-	int ordem = 51;
-	constroiGrafo(&G, &ordem);
+/* Dados compartilhados pelas linhas da matriz de paradas */
+typedef struct {
+	Vert *G;
+	int ordem;
+	int n;
+	const int *v1, *v2, *d1, *d2; /* aresta de cada parada, como em localizaLocalidade() */
+	int *dist;
+} TarefaMatrizParadas;
+
+/*Linha i da matriz de paradas: o mesmo calculo de dijkstra(), mas com
+  distancias e cores em vetores proprios, sem alterar G, para que varias
+  linhas possam ser calculadas ao mesmo tempo*/
+void calculaLinhaParadas(void *arg, int i){
+    TarefaMatrizParadas *t = (TarefaMatrizParadas*) arg;
+    int ordem = t->ordem, n = t->n;
+    int *d = (int*) malloc(sizeof(int) * ordem);
+    char *cor = (char*) malloc(ordem);
+    Aresta *aux;
+    int atual;
 
-	/*vetor de localidades utilizadas no algoritmo. Altere as localidades para obter outras rotas*/
-	char *locais[] = {"Pizza","Mambo","Shopping Patio Higienopolis"};
-	int n = sizeof(locais) / sizeof(locais[0]);
-	melhorRota(G, ordem, locais, n);
-	/*imprimeGrafo(G,ordem);*/
-	destroiGrafo(&G, ordem);
+    if (d == NULL || cor == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    for(int v = 0; v < ordem; v++){
+        d[v] = INT_MAX;
+        cor[v] = BRANCO;
+    }
+    d[t->v1[i]] = t->d1[i];
+    d[t->v2[i]] = t->d2[i];
+    for(;;){
+        /*mesma escolha de menorVertice()*/
+        int menorDist = INT_MAX;
+        atual = -1;
+        for(int v = 1; v < ordem; v++){
+            if (cor[v] != PRETO && d[v] < menorDist){
+                menorDist = d[v];
+                atual = v;
+            }
+        }
+        if (atual == -1) break;
+        for(aux = t->G[atual].prim; aux != NULL; aux = aux->prox){
+            if (d[aux->extremo2] > aux->dist_prox + d[atual]){
+                d[aux->extremo2] = aux->dist_prox + d[atual];
+            }
+        }
+        cor[atual] = PRETO;
+    }
+    for(int j = 0; j < n; j++){
+        int distancia1 = INT_MAX, distancia2 = INT_MAX;
+        if (i == j){
+            DIST(t->dist, n, i, j) = 0;
+            continue;
+        }
+        /*mesma escolha de extremo feita no final de dijkstra()*/
+        if (d[t->v1[j]] != INT_MAX) distancia1 = d[t->v1[j]] + t->d1[j];
+        if (d[t->v2[j]] != INT_MAX) distancia2 = d[t->v2[j]] + t->d2[j];
+        DIST(t->dist, n, i, j) = distancia1 < distancia2 ? distancia1 : distancia2;
+    }
+    free(d);
+    free(cor);
+}
+
+/*Monta a matriz de distancias entre paradas: o indice 0 e "Minha Casa" e o
+  indice i (1..nLugares) e lugares[i-1]. Cada linha usa uma unica execucao de
+  dijkstra, que ja calcula a distancia da origem ate todos os vertices, e as
+  linhas sao repartidas por executaEmParalelo().
+  Retorna vetor alocado com (nLugares+1)^2 posicoes (liberar com free)*/
+int *criaMatrizParadas(Vert G[], int ordem, char *lugares[], int nLugares){
+    int n = nLugares + 1;
+    int v1[n], v2[n], d1[n], d2[n];
+    TarefaMatrizParadas t;
+    int *dist;
+
+    dist = (int*) malloc(sizeof(int) * n * n);
+    if (dist == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    for(int i = 0; i < n; i++){
+        char *nome = (i == 0) ? "Minha Casa" : lugares[i-1];
+        if (!localizaLocalidade(G, ordem, nome, &v1[i], &v2[i], &d1[i], &d2[i])){
+            fprintf(stderr, "Localidade nao encontrada: %s\n", nome);
+            exit(EXIT_FAILURE);
+        }
+    }
+    t.G = G;
+    t.ordem = ordem;
+    t.n = n;
+    t.v1 = v1;
+    t.v2 = v2;
+    t.d1 = d1;
+    t.d2 = d2;
+    t.dist = dist;
+    executaEmParalelo(n, calculaLinhaParadas, &t);
+    return dist;
+}
+
+/* Estado da busca em profundidade do branch and bound sobre a matriz de
+   paradas. A casa e a parada 0; rota[0..prof-1] e a rota parcial corrente. */
+typedef struct {
+	int n;                /* numero de paradas, incluindo a casa */
+	const int *dist;      /* matriz n x n de distancias entre paradas */
+	int *rota;            /* rota parcial corrente */
+	int *visitado;
+	int *melhor;          /* melhor rota completa encontrada (limite superior) */
+	int melhorCusto;
+	int limiteAbandonado; /* menor limite inferior entre os ramos abandonados */
+	long nos;             /* nos explorados */
+	long limiteNos;       /* 0 = sem limite */
+	clock_t limiteTempo;  /* 0 = sem limite */
+	int interrompido;
+} BuscaBB;
+
+/*Rota gulosa (vizinho mais proximo) a partir da casa. Preenche rota[0..n-1]
+  com rota[0] = 0 e retorna o custo do passeio fechado*/
+int rotaGulosa(int n, const int *dist, int rota[]){
+    int usado[n];
+    int custo = 0;
+
+    for(int i = 0; i < n; i++) usado[i] = 0;
+    rota[0] = 0;
+    usado[0] = 1;
+    for(int k = 1; k < n; k++){
+        int ultimo = rota[k-1];
+        int prox = -1;
+        for(int c = 1; c < n; c++){
+            if (!usado[c] && (prox == -1 || DIST(dist, n, ultimo, c) < DIST(dist, n, ultimo, prox))){
+                prox = c;
+            }
+        }
+        rota[k] = prox;
+        usado[prox] = 1;
+        custo += DIST(dist, n, ultimo, prox);
+    }
+    return custo + DIST(dist, n, rota[n-1], 0);
+}
+
+/*Limite inferior para completar a rota parcial que termina em "ultimo":
+  qualquer complemento sai de ultimo para uma parada restante, percorre as
+  restantes (caminho >= arvore geradora minima delas, via Prim) e volta da
+  ultima delas para a casa*/
+int limiteInferiorBB(BuscaBB *b, int ultimo, int custo){
+    int n = b->n;
+    int resto[n], chave[n], naArvore[n];
+    int nResto = 0;
+    int minSaida = INT_MAX, minVolta = INT_MAX, arvore = 0;
+
+    for(int c = 1; c < n; c++){
+        if (!b->visitado[c]) resto[nResto++] = c;
+    }
+    if (nResto == 0) return custo + DIST(b->dist, n, ultimo, 0);
+
+    for(int i = 0; i < nResto; i++){
+        if (DIST(b->dist, n, ultimo, resto[i]) < minSaida) minSaida = DIST(b->dist, n, ultimo, resto[i]);
+        if (DIST(b->dist, n, resto[i], 0) < minVolta) minVolta = DIST(b->dist, n, resto[i], 0);
+        chave[i] = INT_MAX;
+        naArvore[i] = 0;
+    }
+
+    /*Prim O(r^2) sobre as paradas restantes*/
+    chave[0] = 0;
+    for(int k = 0; k < nResto; k++){
+        int u = -1;
+        for(int i = 0; i < nResto; i++){
+            if (!naArvore[i] && (u == -1 || chave[i] < chave[u])) u = i;
+        }
+        naArvore[u] = 1;
+        arvore += chave[u];
+        for(int i = 0; i < nResto; i++){
+            int d = DIST(b->dist, n, resto[u], resto[i]);
+            if (!naArvore[i] && d < chave[i]) chave[i] = d;
+        }
+    }
+    return custo + minSaida + arvore + minVolta;
+}
+
+/*Verifica (a cada 1024 nos, para o tempo) se algum limite da busca foi atingido*/
+int excedeuLimitesBB(BuscaBB *b){
+    if (b->interrompido) return 1;
+    if (b->limiteNos > 0 && b->nos > b->limiteNos) b->interrompido = 1;
+    if (b->limiteTempo != 0 && (b->nos & 1023) == 0 && clock() > b->limiteTempo) b->interrompido = 1;
+    return b->interrompido;
+}
+
+/*Ramificacao em profundidade: filhos ordenados pela parada mais proxima*/
+void ramificaBB(BuscaBB *b, int prof, int custo){
+    int n = b->n;
+    int ultimo = b->rota[prof-1];
+    int filhos[n];
+    int nFilhos = 0;
+    int limite;
+
+    b->nos++;
+    if (prof == n){ /*rota completa: fecha o passeio na casa*/
+        int total = custo + DIST(b->dist, n, ultimo, 0);
+        if (total < b->melhorCusto){
+            b->melhorCusto = total;
+            memcpy(b->melhor, b->rota, sizeof(int) * n);
+        }
+        return;
+    }
+
+    limite = limiteInferiorBB(b, ultimo, custo);
+    if (limite >= b->melhorCusto) return; /*poda*/
+    if (excedeuLimitesBB(b)){
+        /*ramo abandonado: guarda seu limite para o limite inferior global*/
+        if (limite < b->limiteAbandonado) b->limiteAbandonado = limite;
+        return;
+    }
+
+    /*ordena os filhos por insercao pela distancia a partir da ultima parada*/
+    for(int c = 1; c < n; c++){
+        if (b->visitado[c]) continue;
+        int k = nFilhos++;
+        while(k > 0 && DIST(b->dist, n, ultimo, filhos[k-1]) > DIST(b->dist, n, ultimo, c)){
+            filhos[k] = filhos[k-1];
+            k--;
+        }
+        filhos[k] = c;
+    }
+
+    for(int i = 0; i < nFilhos; i++){
+        int c = filhos[i];
+        b->visitado[c] = 1;
+        b->rota[prof] = c;
+        ramificaBB(b, prof + 1, custo + DIST(b->dist, n, ultimo, c));
+        b->visitado[c] = 0;
+    }
+}
+
+/*Passeio fechado mais curto por branch and bound sobre a matriz de paradas
+  (n paradas, casa = 0). O limite superior inicial vem da rota gulosa.
+  limiteNos e limiteSegundos interrompem a busca (0 = sem limite).
+  Preenche rota[0..n-2] com as paradas 1..n-1 na ordem do passeio, o numero de
+  nos explorados e o melhor limite inferior obtido (igual ao custo retornado
+  quando o otimo foi comprovado). Retorna o custo da melhor rota encontrada*/
+int rotaBranchAndBound(int n, const int *dist, int rota[], long limiteNos, double limiteSegundos,
+                       int *limiteInferior, long *nos){
+    BuscaBB b;
+    int rotaAtual[n], visitado[n], melhor[n];
+
+    b.n = n;
+    b.dist = dist;
+    b.rota = rotaAtual;
+    b.visitado = visitado;
+    b.melhor = melhor;
+    b.melhorCusto = rotaGulosa(n, dist, melhor);
+    b.limiteAbandonado = INT_MAX;
+    b.nos = 0;
+    b.limiteNos = limiteNos;
+    b.limiteTempo = 0;
+    if (limiteSegundos > 0){
+        b.limiteTempo = clock() + (clock_t)(limiteSegundos * CLOCKS_PER_SEC);
+    }
+    b.interrompido = 0;
+
+    for(int i = 0; i < n; i++) visitado[i] = 0;
+    visitado[0] = 1;
+    rotaAtual[0] = 0;
+    if (n > 1) ramificaBB(&b, 1, 0);
+
+    for(int i = 1; i < n; i++) rota[i-1] = melhor[i];
+    if (nos != NULL) *nos = b.nos;
+    if (limiteInferior != NULL){
+        *limiteInferior = b.limiteAbandonado < b.melhorCusto ? b.limiteAbandonado : b.melhorCusto;
+    }
+    return b.melhorCusto;
+}
+
+/*Alternativa a melhorRota() sem enumerar as n! permutacoes: branch and bound
+  com limites de arvore geradora minima. Imprime o resultado no mesmo formato*/
+void melhorRotaBB(Vert G[], int ordem, char *lugares[], int nLugares, long limiteNos, double limiteSegundos){
+    int *dist = criaMatrizParadas(G, ordem, lugares, nLugares);
+    int rota[nLugares + 1];
+    int visita[nLugares + 1];
+    int limiteInferior;
+    long nos;
+    int custo;
+
+    custo = rotaBranchAndBound(nLugares + 1, dist, rota, limiteNos, limiteSegundos, &limiteInferior, &nos);
+    printf("Branch and bound: %ld nos explorados\n", nos);
+    if (limiteInferior == custo){
+        printf("Otimo comprovado\n");
+    } else {
+        printf("Busca interrompida: limite inferior = %dm\n", limiteInferior);
+    }
+    for(int i = 0; i < nLugares; i++){
+        visita[i] = rota[i] - 1;
+    }
+    free(dist);
+    imprimeRota(G, ordem, lugares, nLugares, visita, custo);
+}
+
+
+/*Tempo de deslocamento em minutos (arredondado para cima) entre duas paradas*/
+int tempoViagem(const RestricoesRota *r, int metros){
+    return (metros + r->velocidade - 1) / r->velocidade;
+}
+
+/*Verifica as janelas de tempo e a capacidade de um passeio fechado.
+  rota[0..n-2] contem as paradas 1..n-1 (atributos em attr[parada-1]).
+  Retorna 1 se viavel, preenchendo a distancia total em *custo*/
+int avaliaRotaJanelas(int n, const int *dist, const AtributosLocalidade attr[],
+                      const RestricoesRota *r, const int rota[], int *custo){
+    int tempo = r->saida, carga = 0, total = 0, ultimo = 0;
+
+    for(int i = 0; i < n - 1; i++){
+        const AtributosLocalidade *a = &attr[rota[i] - 1];
+        tempo += tempoViagem(r, DIST(dist, n, ultimo, rota[i]));
+        if (tempo > a->fechamento) return 0;
+        if (tempo < a->abertura) tempo = a->abertura; /*espera a abertura*/
+        tempo += a->servico;
+        carga += a->demanda;
+        if (carga > r->capacidade) return 0;
+        total += DIST(dist, n, ultimo, rota[i]);
+        ultimo = rota[i];
+    }
+    tempo += tempoViagem(r, DIST(dist, n, ultimo, 0));
+    if (tempo > r->retorno) return 0;
+    if (custo != NULL) *custo = total + DIST(dist, n, ultimo, 0);
+    return 1;
+}
+
+/* Busca exata com janelas de tempo: reaproveita o estado e o limite inferior
+   do branch and bound sem restricoes. */
+typedef struct {
+	BuscaBB bb;
+	const AtributosLocalidade *attr;
+	const RestricoesRota *r;
+} BuscaJanelas;
+
+/*Poda antecipada: a rota parcial que termina em ultimo no instante tempo e
+  inviavel se alguma parada restante ja nao pode ser alcancada antes do
+  fechamento (a viagem direta e a mais rapida possivel, pois dist contem
+  caminhos minimos) ou se nao ha tempo de voltar para casa*/
+int rotaParcialInviavel(BuscaJanelas *b, int ultimo, int tempo){
+    int n = b->bb.n;
+
+    for(int c = 1; c < n; c++){
+        if (b->bb.visitado[c]) continue;
+        if (tempo + tempoViagem(b->r, DIST(b->bb.dist, n, ultimo, c)) > b->attr[c-1].fechamento) return 1;
+    }
+    return tempo + tempoViagem(b->r, DIST(b->bb.dist, n, ultimo, 0)) > b->r->retorno;
+}
+
+void ramificaJanelas(BuscaJanelas *b, int prof, int custo, int tempo, int carga){
+    int n = b->bb.n;
+    int ultimo = b->bb.rota[prof-1];
+    int filhos[n];
+    int nFilhos = 0;
+
+    b->bb.nos++;
+    if (rotaParcialInviavel(b, ultimo, tempo)) return;
+    if (prof == n){
+        int total = custo + DIST(b->bb.dist, n, ultimo, 0);
+        if (total < b->bb.melhorCusto){
+            b->bb.melhorCusto = total;
+            memcpy(b->bb.melhor, b->bb.rota, sizeof(int) * n);
+        }
+        return;
+    }
+    if (limiteInferiorBB(&b->bb, ultimo, custo) >= b->bb.melhorCusto) return;
+
+    for(int c = 1; c < n; c++){
+        if (b->bb.visitado[c]) continue;
+        int k = nFilhos++;
+        while(k > 0 && DIST(b->bb.dist, n, ultimo, filhos[k-1]) > DIST(b->bb.dist, n, ultimo, c)){
+            filhos[k] = filhos[k-1];
+            k--;
+        }
+        filhos[k] = c;
+    }
+
+    for(int i = 0; i < nFilhos; i++){
+        int c = filhos[i];
+        const AtributosLocalidade *a = &b->attr[c-1];
+        /*chegada <= fechamento ja garantida por rotaParcialInviavel()*/
+        int chegada = tempo + tempoViagem(b->r, DIST(b->bb.dist, n, ultimo, c));
+        if (carga + a->demanda > b->r->capacidade) continue;
+        if (chegada < a->abertura) chegada = a->abertura;
+        b->bb.visitado[c] = 1;
+        b->bb.rota[prof] = c;
+        ramificaJanelas(b, prof + 1, custo + DIST(b->bb.dist, n, ultimo, c),
+                        chegada + a->servico, carga + a->demanda);
+        b->bb.visitado[c] = 0;
+    }
+}
+
+/*Heuristica para muitas paradas: vizinho mais proximo entre as paradas que
+  mantem a rota parcial viavel, seguido de 2-opt aceitando so trocas viaveis.
+  Retorna o custo ou INT_MAX se nao encontrou rota viavel*/
+int rotaJanelasHeuristica(int n, const int *dist, const AtributosLocalidade attr[],
+                          const RestricoesRota *r, int rota[]){
+    BuscaJanelas b;
+    int visitado[n], atual[n];
+    int tempo = r->saida, carga = 0, ultimo = 0, custo;
+    int melhorou = 1;
+
+    memset(&b, 0, sizeof(b));
+    b.bb.n = n;
+    b.bb.dist = dist;
+    b.bb.visitado = visitado;
+    b.attr = attr;
+    b.r = r;
+    for(int i = 0; i < n; i++) visitado[i] = 0;
+    visitado[0] = 1;
+
+    for(int k = 0; k < n - 1; k++){
+        int prox = -1, proxTempo = 0;
+        for(int c = 1; c < n; c++){
+            int chegada;
+            if (visitado[c] || carga + attr[c-1].demanda > r->capacidade) continue;
+            chegada = tempo + tempoViagem(r, DIST(dist, n, ultimo, c));
+            if (chegada > attr[c-1].fechamento) continue;
+            if (chegada < attr[c-1].abertura) chegada = attr[c-1].abertura;
+            chegada += attr[c-1].servico;
+            visitado[c] = 1;
+            if (!rotaParcialInviavel(&b, c, chegada) &&
+                (prox == -1 || DIST(dist, n, ultimo, c) < DIST(dist, n, ultimo, prox))){
+                prox = c;
+                proxTempo = chegada;
+            }
+            visitado[c] = 0;
+        }
+        if (prox == -1) return INT_MAX;
+        visitado[prox] = 1;
+        rota[k] = prox;
+        tempo = proxTempo;
+        carga += attr[prox-1].demanda;
+        ultimo = prox;
+    }
+    if (!avaliaRotaJanelas(n, dist, attr, r, rota, &custo)) return INT_MAX;
+
+    /*2-opt: inverte o trecho rota[i..j] quando a rota continua viavel e encurta*/
+    while(melhorou){
+        melhorou = 0;
+        for(int i = 0; i < n - 2; i++){
+            for(int j = i + 1; j < n - 1; j++){
+                int novoCusto;
+                memcpy(atual, rota, sizeof(int) * (n - 1));
+                for(int a = i, z = j; a < z; a++, z--){
+                    int t = atual[a];
+                    atual[a] = atual[z];
+                    atual[z] = t;
+                }
+                if (avaliaRotaJanelas(n, dist, attr, r, atual, &novoCusto) && novoCusto < custo){
+                    memcpy(rota, atual, sizeof(int) * (n - 1));
+                    custo = novoCusto;
+                    melhorou = 1;
+                }
+            }
+        }
+    }
+    return custo;
+}
+
+/*Passeio fechado mais curto respeitando janelas de tempo e capacidade.
+  Exato (busca em profundidade com poda de rotas parciais inviaveis e limite
+  inferior do branch and bound) ate LIMITE_EXATO_JANELAS paradas, heuristico
+  acima disso. Mesma convencao de rota[] de rotaBranchAndBound(); retorna o
+  custo ou INT_MAX quando nao ha rota viavel*/
+int rotaJanelas(int n, const int *dist, const AtributosLocalidade attr[],
+                const RestricoesRota *r, int rota[], long *nos){
+    BuscaJanelas b;
+    int rotaAtual[n], visitado[n], melhor[n];
+    int custo;
+
+    custo = rotaJanelasHeuristica(n, dist, attr, r, rota);
+    if (nos != NULL) *nos = 0;
+    if (n - 1 > LIMITE_EXATO_JANELAS) return custo;
+
+    memset(&b, 0, sizeof(b));
+    b.bb.n = n;
+    b.bb.dist = dist;
+    b.bb.rota = rotaAtual;
+    b.bb.visitado = visitado;
+    b.bb.melhor = melhor;
+    b.bb.melhorCusto = custo; /*limite superior da heuristica, se viavel*/
+    b.bb.nos = 0;
+    b.attr = attr;
+    b.r = r;
+    for(int i = 0; i < n; i++) visitado[i] = 0;
+    visitado[0] = 1;
+    rotaAtual[0] = 0;
+    melhor[0] = -1;
+    ramificaJanelas(&b, 1, 0, r->saida, 0);
+
+    if (melhor[0] == 0){ /*a busca exata encontrou rota melhor que a heuristica*/
+        for(int i = 1; i < n; i++) rota[i-1] = melhor[i];
+    }
+    if (nos != NULL) *nos = b.bb.nos;
+    return b.bb.melhorCusto;
+}
+
+/*Imprime "hh:mm" a partir de minutos*/
+void imprimeHorario(int minutos){
+    printf("%02d:%02d", minutos / 60, minutos % 60);
+}
+
+/*Modo com restricoes de melhorRota(): cada parada traz janela de atendimento,
+  duracao do servico e demanda; o passeio respeita a capacidade e o horario de
+  retorno. Imprime a agenda e a rota no mesmo formato de melhorRota()*/
+void melhorRotaJanelas(Vert G[], int ordem, AtributosLocalidade paradas[], int nParadas, RestricoesRota *r){
+    char *lugares[nParadas + 1];
+    int rota[nParadas + 1], visita[nParadas + 1];
+    int *dist;
+    int custo, tempo, carga = 0, ultimo = 0;
+    long nos;
+
+    for(int i = 0; i < nParadas; i++) lugares[i] = paradas[i].nome;
+    dist = criaMatrizParadas(G, ordem, lugares, nParadas);
+    custo = rotaJanelas(nParadas + 1, dist, paradas, r, rota, &nos);
+    if (custo == INT_MAX && nParadas > LIMITE_EXATO_JANELAS){
+        /*so a heuristica foi executada: nao prova que nao exista rota*/
+        printf("A heuristica nao encontrou rota viavel com as janelas de tempo e capacidade informadas\n");
+        printf("(acima de %d paradas a busca exata nao e executada)\n", LIMITE_EXATO_JANELAS);
+        free(dist);
+        return;
+    }
+    if (custo == INT_MAX){
+        printf("Nenhuma rota viavel com as janelas de tempo e capacidade informadas\n");
+        free(dist);
+        return;
+    }
+
+    printf("Agenda (%ld nos explorados)\n", nos);
+    printf("Saida de casa: ");
+    imprimeHorario(r->saida);
+    printf("\n");
+    tempo = r->saida;
+    for(int i = 0; i < nParadas; i++){
+        AtributosLocalidade *a = &paradas[rota[i] - 1];
+        tempo += tempoViagem(r, DIST(dist, nParadas + 1, ultimo, rota[i]));
+        printf("%s: chegada ", a->nome);
+        imprimeHorario(tempo);
+        if (tempo < a->abertura) tempo = a->abertura;
+        tempo += a->servico;
+        carga += a->demanda;
+        printf(", saida ");
+        imprimeHorario(tempo);
+        printf(", carga %d/%d\n", carga, r->capacidade);
+        ultimo = rota[i];
+        visita[i] = rota[i] - 1;
+    }
+    tempo += tempoViagem(r, DIST(dist, nParadas + 1, ultimo, 0));
+    printf("Chegada em casa: ");
+    imprimeHorario(tempo);
+    printf("\n\n");
+    free(dist);
+    imprimeRota(G, ordem, lugares, nParadas, visita, custo);
+}
+
+/*Enumera todas as permutacoes (algoritmo de Heap) filtrando as viaveis;
+  referencia para o benchmark de melhorRotaJanelas()*/
+int filtraPermutacoesJanelas(int n, const int *dist, const AtributosLocalidade attr[],
+                             const RestricoesRota *r, long *avaliadas){
+    int rota[n], c[n];
+    int melhor = INT_MAX, custo, i = 0;
+
+    for(int k = 0; k < n - 1; k++){
+        rota[k] = k + 1;
+        c[k] = 0;
+    }
+    rota[n-1] = 0; /*posicao nao usada; evita n == 1 gerar vetor vazio*/
+    *avaliadas = 1;
+    if (avaliaRotaJanelas(n, dist, attr, r, rota, &custo) && custo < melhor) melhor = custo;
+    while(i < n - 1){
+        if (c[i] < i){
+            int j = (i % 2 == 0) ? 0 : c[i];
+            int t = rota[j];
+            rota[j] = rota[i];
+            rota[i] = t;
+            (*avaliadas)++;
+            if (avaliaRotaJanelas(n, dist, attr, r, rota, &custo) && custo < melhor) melhor = custo;
+            c[i]++;
+            i = 0;
+        } else {
+            c[i] = 0;
+            i++;
+        }
+    }
+    return melhor;
+}
+
+/*Compara a busca com poda antecipada contra filtrar todas as permutacoes,
+  com janelas geradas ao redor de um passeio aleatorio (instancia viavel)*/
+void benchmarkJanelas(Vert G[], int ordem, char *lugares[], int nLugares){
+    AtributosLocalidade paradas[nLugares];
+    RestricoesRota r = {8 * 60, 20 * 60, 0, 80};
+    int *dist, rota[nLugares + 1], ordemAleatoria[nLugares];
+    int tempo = r.saida, ultimo = 0, custoPoda, custoFiltro;
+    long nos, avaliadas;
+    clock_t t;
+    double tPoda, tFiltro;
+
+    dist = criaMatrizParadas(G, ordem, lugares, nLugares);
+    srand(7);
+    for(int i = 0; i < nLugares; i++) ordemAleatoria[i] = i;
+    for(int i = nLugares - 1; i > 0; i--){
+        int j = rand() % (i + 1);
+        int x = ordemAleatoria[i];
+        ordemAleatoria[i] = ordemAleatoria[j];
+        ordemAleatoria[j] = x;
+    }
+    for(int k = 0; k < nLugares; k++){
+        int p = ordemAleatoria[k];
+        AtributosLocalidade *a = &paradas[p];
+        strcpy(a->nome, lugares[p]);
+        tempo += tempoViagem(&r, DIST(dist, nLugares + 1, ultimo, p + 1));
+        a->abertura = tempo - rand() % 30;
+        a->fechamento = tempo + 10 + rand() % 50;
+        a->servico = 5 + rand() % 10;
+        a->demanda = 1 + rand() % 3;
+        r.capacidade += a->demanda;
+        tempo += a->servico;
+        ultimo = p + 1;
+    }
+
+    t = clock();
+    custoPoda = rotaJanelas(nLugares + 1, dist, paradas, &r, rota, &nos);
+    tPoda = (double)(clock() - t) / CLOCKS_PER_SEC;
+    t = clock();
+    custoFiltro = filtraPermutacoesJanelas(nLugares + 1, dist, paradas, &r, &avaliadas);
+    tFiltro = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+    printf("Janelas de tempo com %d paradas\n", nLugares);
+    printf("Poda de rotas parciais: %dm, %ld nos, %.3fs\n", custoPoda, nos, tPoda);
+    printf("Filtro de permutacoes:  %dm, %ld rotas, %.3fs\n", custoFiltro, avaliadas, tFiltro);
+    free(dist);
+}
+
+
+/*Renumera os vertices em ordem Reverse Cuthill-McKee: uma busca em largura a
+  partir do vertice de menor grau, visitando os vizinhos em ordem crescente de
+  grau, com a ordem final invertida. Vertices vizinhos ficam proximos no vetor
+  Vert e as celulas de aresta sao realocadas na nova ordem, melhorando a
+  localidade de memoria do dijkstra(). O campo id de cada vertice preserva o
+  id original (tabela de mapeamento), entao imprimeCaminho() e imprimeGrafo()
+  continuam exibindo os ids do usuario. O vertice 0 (nao usado) fica fixo.
+  Se novoIndice != NULL, recebe a nova posicao de cada posicao antiga*/
+void reordenaGrafo(Vert **G, int ordem, int novoIndice[]){
+    Vert *antigo = *G;
+    Vert *novo;
+    int *grau, *ordemRCM, *posicao;
+    int inicio = 1, fim = 1;
+
+    grau = (int*) malloc(sizeof(int) * ordem);
+    ordemRCM = (int*) malloc(sizeof(int) * ordem);
+    posicao = (int*) malloc(sizeof(int) * ordem);
+    novo = (Vert*) malloc(sizeof(Vert) * ordem);
+    if (grau == NULL || ordemRCM == NULL || posicao == NULL || novo == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for(int i = 0; i < ordem; i++){
+        Aresta *aux;
+        grau[i] = 0;
+        for(aux = antigo[i].prim; aux != NULL; aux = aux->prox) grau[i]++;
+        posicao[i] = -1;
+    }
+    ordemRCM[0] = 0;
+    posicao[0] = 0;
+
+    /*Cuthill-McKee: uma busca em largura por componente conexa*/
+    while(fim < ordem){
+        int raiz = -1;
+        for(int i = 1; i < ordem; i++){
+            if (posicao[i] == -1 && (raiz == -1 || grau[i] < grau[raiz])) raiz = i;
+        }
+        posicao[raiz] = fim;
+        ordemRCM[fim++] = raiz;
+        for(; inicio < fim; inicio++){
+            int v = ordemRCM[inicio];
+            int primeiroFilho = fim;
+            Aresta *aux;
+            for(aux = antigo[v].prim; aux != NULL; aux = aux->prox){
+                int w = aux->extremo2;
+                if (w == 0 || posicao[w] != -1) continue;
+                /*insere mantendo os filhos em ordem crescente de grau*/
+                int k = fim++;
+                while(k > primeiroFilho && grau[ordemRCM[k-1]] > grau[w]){
+                    ordemRCM[k] = ordemRCM[k-1];
+                    k--;
+                }
+                ordemRCM[k] = w;
+                posicao[w] = 0; /*nesta fase posicao so marca visitado*/
+            }
+        }
+    }
+
+    /*Reverse: inverte a ordem dos vertices 1..ordem-1*/
+    for(int i = 1, j = ordem - 1; i < j; i++, j--){
+        int t = ordemRCM[i];
+        ordemRCM[i] = ordemRCM[j];
+        ordemRCM[j] = t;
+    }
+    for(int i = 0; i < ordem; i++) posicao[ordemRCM[i]] = i;
+
+    /*copia os vertices e realoca as arestas na nova ordem*/
+    for(int p = 0; p < ordem; p++){
+        Vert *v = &antigo[ordemRCM[p]];
+        Aresta *aux, **ultima;
+        novo[p] = *v;
+        novo[p].prim = NULL;
+        ultima = &novo[p].prim;
+        for(aux = v->prim; aux != NULL; aux = aux->prox){
+            Aresta *a = (Aresta*) malloc(sizeof(Aresta));
+            if (a == NULL){
+                fprintf(stderr, "Erro de alocacao\n");
+                exit(EXIT_FAILURE);
+            }
+            *a = *aux;
+            a->extremo2 = posicao[aux->extremo2];
+            a->prox = NULL;
+            *ultima = a;
+            ultima = &a->prox;
+        }
+    }
+
+    if (novoIndice != NULL){
+        for(int i = 0; i < ordem; i++) novoIndice[i] = posicao[i];
+    }
+    destroiGrafo(G, ordem);
+    *G = novo;
+    free(grau);
+    free(ordemRCM);
+    free(posicao);
+}
+
+/*Gera um grafo em grade linhas x colunas com ids embaralhados (como ocorre com
+  dados externos), distancias aleatorias entre 50 e 200m, nLocalidades
+  localidades "Local k" e mais uma "Minha Casa", todas em arestas distintas.
+  O vertice 0 fica sem arestas*/
+void geraGrafoGrade(Vert **G, int *ordem, int linhas, int colunas, int nLocalidades, unsigned semente){
+    int nVertices = linhas * colunas;
+    int nArestas = linhas * (colunas - 1) + (linhas - 1) * colunas;
+    int *id = (int*) malloc(sizeof(int) * nVertices);
+    char *comLocal = (char*) calloc(nArestas, 1);
+    int k = 0, nomeadas = 0;
+
+    if (id == NULL || comLocal == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    if (nLocalidades > nArestas - 1) nLocalidades = nArestas - 1;
+    srand(semente);
+
+    /*embaralha os ids (Fisher-Yates)*/
+    for(int i = 0; i < nVertices; i++) id[i] = i + 1;
+    for(int i = nVertices - 1; i > 0; i--){
+        int j = rand() % (i + 1);
+        int t = id[i];
+        id[i] = id[j];
+        id[j] = t;
+    }
+    for(int i = 0; i <= nLocalidades; i++){ /*1 = "Local k", 2 = "Minha Casa"*/
+        int a;
+        do { a = rand() % nArestas; } while(comLocal[a]);
+        comLocal[a] = (i == 0) ? 2 : 1;
+    }
+
+    *ordem = nVertices + 1;
+    criaGrafo(G, *ordem);
+    for(int r = 0; r < linhas; r++){
+        for(int c = 0; c < colunas; c++){
+            int viz[2][2] = {{r, c + 1}, {r + 1, c}};
+            for(int d = 0; d < 2; d++){
+                int r2 = viz[d][0], c2 = viz[d][1];
+                int dist = 50 + rand() % 151;
+                char nome[MAX_CHARS] = "";
+                int dv = 0;
+                if (r2 >= linhas || c2 >= colunas) continue;
+                if (comLocal[k]){
+                    if (comLocal[k] == 2) strcpy(nome, "Minha Casa");
+                    else sprintf(nome, "Local %d", nomeadas++);
+                    dv = 1 + rand() % (dist - 1);
+                }
+                acrescentaAresta(*G, *ordem, id[r * colunas + c], id[r2 * colunas + c2],
+                                 dist, nome, dv, dist - dv);
+                k++;
+            }
+        }
+    }
+    free(id);
+    free(comLocal);
+}
+
+
+/*Mede o tempo de dijkstra() em uma grade com ids embaralhados antes e depois
+  de reordenaGrafo(), conferindo que as distancias nao mudam*/
+void benchmarkReordenacao(int linhas, int colunas, int consultas){
+    Vert *G = NULL;
+    int ordem;
+    int nLocalidades = 2 * consultas;
+    int *antes = (int*) malloc(sizeof(int) * consultas);
+    char origem[MAX_CHARS], destino[MAX_CHARS];
+    clock_t t;
+    double tAntes, tDepois;
+
+    geraGrafoGrade(&G, &ordem, linhas, colunas, nLocalidades, 42);
+    printf("Grade %dx%d: %d vertices, %d consultas\n", linhas, colunas, ordem - 1, consultas);
+
+    t = clock();
+    for(int q = 0; q < consultas; q++){
+        sprintf(origem, "Local %d", 2 * q);
+        sprintf(destino, "Local %d", 2 * q + 1);
+        antes[q] = abs(dijkstra(G, ordem, origem, destino));
+    }
+    tAntes = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+    t = clock();
+    reordenaGrafo(&G, ordem, NULL);
+    printf("Reordenacao RCM: %.3fs\n", (double)(clock() - t) / CLOCKS_PER_SEC);
+
+    t = clock();
+    for(int q = 0; q < consultas; q++){
+        sprintf(origem, "Local %d", 2 * q);
+        sprintf(destino, "Local %d", 2 * q + 1);
+        if (abs(dijkstra(G, ordem, origem, destino)) != antes[q]){
+            printf("Distancia divergente na consulta %d\n", q);
+        }
+    }
+    tDepois = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+    printf("dijkstra() ids embaralhados: %.3fms/consulta\n", 1000 * tAntes / consultas);
+    printf("dijkstra() ordem RCM:        %.3fms/consulta\n", 1000 * tDepois / consultas);
+    free(antes);
+    destroiGrafo(&G, ordem);
+}
+
+
+/*Confere rotaBranchAndBound() contra a forca bruta em subconjuntos aleatorios
+  de ate LIMITE_FORCA_BRUTA localidades e mede o tempo em grades com 15, 20 e
+  25 paradas (limite de limiteSegundos por busca)*/
+void benchmarkBranchAndBound(Vert G[], int ordem, char *lugares[], int nLugares, int testes, double limiteSegundos){
+    int iguais = 0;
+    int tamanhos[] = {15, 20, 25};
+
+    srand(5);
+    for(int t = 0; t < testes; t++){
+        int m = 2 + rand() % (LIMITE_FORCA_BRUTA - 1);
+        char *sub[nLugares];
+        int visita[LIMITE_FORCA_BRUTA], rota[LIMITE_FORCA_BRUTA + 1];
+        int *dist, custoForca, custoBB;
+
+        if (m > nLugares) m = nLugares;
+        /*embaralha e usa os m primeiros*/
+        for(int i = 0; i < nLugares; i++) sub[i] = lugares[i];
+        for(int i = nLugares - 1; i > 0; i--){
+            int j = rand() % (i + 1);
+            char *x = sub[i];
+            sub[i] = sub[j];
+            sub[j] = x;
+        }
+        custoForca = rotaForcaBruta(G, ordem, sub, m, visita);
+        dist = criaMatrizParadas(G, ordem, sub, m);
+        custoBB = rotaBranchAndBound(m + 1, dist, rota, 0, 0, NULL, NULL);
+        free(dist);
+        if (custoBB == custoForca) iguais++;
+        else printf("Divergencia com %d paradas: forca bruta %dm, branch and bound %dm\n", m, custoForca, custoBB);
+    }
+    printf("Branch and bound x forca bruta: %d/%d rotas com o mesmo custo\n", iguais, testes);
+
+    for(int k = 0; k < (int)(sizeof(tamanhos) / sizeof(tamanhos[0])); k++){
+        int n = tamanhos[k];
+        Vert *grade = NULL;
+        int ordemGrade, limiteInferior, custo;
+        int rota[n + 1];
+        char *paradas[n];
+        int *dist;
+        long nos;
+        clock_t t;
+
+        geraGrafoGrade(&grade, &ordemGrade, 30, 30, n, 3);
+        for(int i = 0; i < n; i++){
+            paradas[i] = (char*) malloc(MAX_CHARS);
+            sprintf(paradas[i], "Local %d", i);
+        }
+        dist = criaMatrizParadas(grade, ordemGrade, paradas, n);
+        t = clock();
+        custo = rotaBranchAndBound(n + 1, dist, rota, 0, limiteSegundos, &limiteInferior, &nos);
+        printf("%d paradas: %dm, %ld nos, %.3fs%s\n", n, custo, nos,
+               (double)(clock() - t) / CLOCKS_PER_SEC,
+               limiteInferior == custo ? " (otimo comprovado)" : " (interrompido)");
+        for(int i = 0; i < n; i++) free(paradas[i]);
+        free(dist);
+        destroiGrafo(&grade, ordemGrade);
+    }
+}
+
+
+/*Custo do passeio fechado casa -> paradas[0..m-1] -> casa*/
+int custoRotaVeiculo(int n, const int *dist, const int paradas[], int m){
+    int custo = 0, ultimo = 0;
+
+    for(int i = 0; i < m; i++){
+        custo += DIST(dist, n, ultimo, paradas[i]);
+        ultimo = paradas[i];
+    }
+    return custo + DIST(dist, n, ultimo, 0);
+}
+
+/*2-opt sobre um passeio fechado rota[0..n-1] com rota[0] = casa fixa*/
+void melhora2opt(int n, const int *dist, int rota[]){
+    int melhorou = 1;
+
+    while(melhorou){
+        melhorou = 0;
+        for(int i = 1; i < n - 1; i++){
+            for(int j = i + 1; j < n; j++){
+                int a = rota[i-1], b = rota[i], c = rota[j], e = rota[(j + 1) % n];
+                if (DIST(dist, n, a, c) + DIST(dist, n, b, e) < DIST(dist, n, a, b) + DIST(dist, n, c, e)){
+                    for(int x = i, z = j; x < z; x++, z--){
+                        int t = rota[x];
+                        rota[x] = rota[z];
+                        rota[z] = t;
+                    }
+                    melhorou = 1;
+                }
+            }
+        }
+    }
+}
+
+/*Otimiza a ordem das paradas de um veiculo sobre a submatriz (casa + suas
+  paradas): branch and bound ate LIMITE_EXATO_VEICULO paradas, vizinho mais
+  proximo com 2-opt acima disso*/
+void otimizaRotaVeiculo(int n, const int *dist, RotaVeiculo *v){
+    int m = v->nParadas + 1;
+    int *sub = (int*) malloc(sizeof(int) * m * m);
+    int *rota = (int*) malloc(sizeof(int) * m);
+    int *mapa = (int*) malloc(sizeof(int) * m);
+
+    if (sub == NULL || rota == NULL || mapa == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    mapa[0] = 0;
+    for(int i = 1; i < m; i++) mapa[i] = v->paradas[i-1];
+    for(int i = 0; i < m; i++){
+        for(int j = 0; j < m; j++) DIST(sub, m, i, j) = DIST(dist, n, mapa[i], mapa[j]);
+    }
+
+    if (v->nParadas <= LIMITE_EXATO_VEICULO){
+        rotaBranchAndBound(m, sub, rota, 0, 0, NULL, NULL);
+    } else {
+        rotaGulosa(m, sub, rota);
+        melhora2opt(m, sub, rota);
+        for(int i = 1; i < m; i++) rota[i-1] = rota[i];
+    }
+    for(int i = 0; i < v->nParadas; i++) v->paradas[i] = mapa[rota[i]];
+    v->custo = custoRotaVeiculo(n, dist, v->paradas, v->nParadas);
+    free(sub);
+    free(rota);
+    free(mapa);
+}
+
+/* Dados compartilhados pelas tarefas que otimizam a rota de cada veiculo */
+typedef struct {
+	int n;
+	const int *dist;
+	RotaVeiculo *v;
+} TarefaVeiculo;
+
+void executaTarefaVeiculo(void *arg, int i){
+    TarefaVeiculo *t = (TarefaVeiculo*) arg;
+    otimizaRotaVeiculo(t->n, t->dist, &t->v[i]);
+}
+
+/*Otimiza a rota de cada veiculo; com USA_PTHREAD, os veiculos sao repartidos
+  entre as threads de executaEmParalelo()*/
+void otimizaVeiculos(int n, const int *dist, RotaVeiculo v[], int k){
+    TarefaVeiculo t;
+
+    t.n = n;
+    t.dist = dist;
+    t.v = v;
+    executaEmParalelo(k, executaTarefaVeiculo, &t);
+}
+
+/* Economia de Clarke-Wright de ligar as paradas i e j na mesma rota */
+typedef struct {
+	int i, j;
+	int economia;
+} Economia;
+
+int comparaEconomia(const void *a, const void *b){
+    return ((const Economia*) b)->economia - ((const Economia*) a)->economia;
+}
+
+/*Inverte a lista encadeada da rota r (troca prox/ant e inicio/fim)*/
+void inverteRotaEconomia(int r, int inicio[], int fim[], int prox[], int ant[]){
+    int p = inicio[r];
+    while(p != -1){
+        int t = prox[p];
+        prox[p] = ant[p];
+        ant[p] = t;
+        p = t;
+    }
+    p = inicio[r];
+    inicio[r] = fim[r];
+    fim[r] = p;
+}
+
+/*Agrupa as paradas 1..n-1 em k rotas pelo algoritmo de economias
+  (Clarke-Wright): cada parada comeca em sua propria rota e as rotas sao
+  unidas pelas extremidades em ordem decrescente de economia, com no maximo
+  ceil((n-1)/k) paradas por rota para equilibrar os veiculos. Se sobrarem
+  mais de k rotas, as menores sao concatenadas*/
+void agrupaEconomias(int n, const int *dist, int k, RotaVeiculo v[]){
+    int m = n - 1;
+    int limite = (m + k - 1) / k;
+    int nRotas = m;
+    int *rotaDe = (int*) malloc(sizeof(int) * n);
+    int *inicio = (int*) malloc(sizeof(int) * n);
+    int *fim = (int*) malloc(sizeof(int) * n);
+    int *prox = (int*) malloc(sizeof(int) * n);
+    int *ant = (int*) malloc(sizeof(int) * n);
+    int *tamanho = (int*) malloc(sizeof(int) * n);
+    char *ativa = (char*) malloc(n); /*ativa[r]: a rota de identificador r existe*/
+    long nEconomias = (long) m * (m - 1) / 2, e = 0;
+    Economia *economias = (Economia*) malloc(sizeof(Economia) * (nEconomias > 0 ? nEconomias : 1));
+
+    if (rotaDe == NULL || inicio == NULL || fim == NULL || prox == NULL ||
+        ant == NULL || tamanho == NULL || ativa == NULL || economias == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    for(int i = 1; i < n; i++){
+        rotaDe[i] = inicio[i] = fim[i] = i;
+        prox[i] = ant[i] = -1;
+        tamanho[i] = 1;
+        ativa[i] = 1;
+        for(int j = i + 1; j < n; j++){
+            economias[e].i = i;
+            economias[e].j = j;
+            economias[e].economia = DIST(dist, n, 0, i) + DIST(dist, n, 0, j) - DIST(dist, n, i, j);
+            e++;
+        }
+    }
+    qsort(economias, nEconomias, sizeof(Economia), comparaEconomia);
+
+    for(e = 0; e < nEconomias && nRotas > k; e++){
+        int i = economias[e].i, j = economias[e].j;
+        int ri = rotaDe[i], rj = rotaDe[j];
+        if (ri == rj || tamanho[ri] + tamanho[rj] > limite) continue;
+        if (i != inicio[ri] && i != fim[ri]) continue; /*so une extremidades*/
+        if (j != inicio[rj] && j != fim[rj]) continue;
+        if (i == inicio[ri]) inverteRotaEconomia(ri, inicio, fim, prox, ant);
+        if (j == fim[rj]) inverteRotaEconomia(rj, inicio, fim, prox, ant);
+        /*agora i e o fim de ri e j o inicio de rj*/
+        prox[i] = j;
+        ant[j] = i;
+        fim[ri] = fim[rj];
+        tamanho[ri] += tamanho[rj];
+        for(int p = j; p != -1; p = prox[p]) rotaDe[p] = ri;
+        ativa[rj] = 0;
+        nRotas--;
+    }
+
+    /*rotas restantes: concatena as duas menores ate sobrarem k*/
+    while(nRotas > k){
+        int a = -1, b = -1;
+        for(int i = 1; i < n; i++){
+            if (!ativa[i]) continue;
+            if (a == -1 || tamanho[i] < tamanho[a]){ b = a; a = i; }
+            else if (b == -1 || tamanho[i] < tamanho[b]) b = i;
+        }
+        prox[fim[a]] = inicio[b];
+        ant[inicio[b]] = fim[a];
+        fim[a] = fim[b];
+        tamanho[a] += tamanho[b];
+        for(int p = inicio[b]; p != -1; p = prox[p]) rotaDe[p] = a;
+        ativa[b] = 0;
+        nRotas--;
+    }
+
+    /*copia as rotas para os veiculos (veiculos sem rota ficam vazios)*/
+    for(int r = 0; r < k; r++) v[r].nParadas = 0;
+    for(int i = 1, r = 0; i < n; i++){
+        if (!ativa[i]) continue;
+        for(int p = inicio[i]; p != -1; p = prox[p]) v[r].paradas[v[r].nParadas++] = p;
+        r++;
+    }
+    free(rotaDe);
+    free(inicio);
+    free(fim);
+    free(prox);
+    free(ant);
+    free(tamanho);
+    free(ativa);
+    free(economias);
+}
+
+/*Compara solucoes pelo maior percurso (makespan) e depois pela distancia total*/
+int melhorSolucaoVeiculos(int makespan, int total, int makespanAtual, int totalAtual){
+    return makespan < makespanAtual || (makespan == makespanAtual && total < totalAtual);
+}
+
+/*Maior custo entre os veiculos, trocando os custos de a e b pelos informados*/
+int makespanVeiculos(RotaVeiculo v[], int k, int a, int custoA, int b, int custoB){
+    int maior = 0;
+    for(int r = 0; r < k; r++){
+        int c = (r == a) ? custoA : (r == b) ? custoB : v[r].custo;
+        if (c > maior) maior = c;
+    }
+    return maior;
+}
+
+/*Movimentos entre rotas com a ordem atual de cada veiculo: realocar uma
+  parada para a melhor posicao de outra rota e trocar paradas entre duas
+  rotas. Aplica cada movimento que melhora (makespan, total).
+  Retorna 1 se alguma melhora foi aplicada*/
+int melhoraEntreRotas(int n, const int *dist, RotaVeiculo v[], int k){
+    int total = 0, makespan, melhorou = 0;
+
+    for(int r = 0; r < k; r++) total += v[r].custo;
+    makespan = makespanVeiculos(v, k, -1, 0, -1, 0);
+
+    /*realocacao*/
+    for(int a = 0; a < k; a++){
+        for(int ia = 0; ia < v[a].nParadas; ia++){
+            int *pa = v[a].paradas;
+            int s = pa[ia];
+            int antA = ia > 0 ? pa[ia-1] : 0, proxA = ia < v[a].nParadas - 1 ? pa[ia+1] : 0;
+            int custoA = v[a].custo + DIST(dist, n, antA, proxA) - DIST(dist, n, antA, s) - DIST(dist, n, s, proxA);
+            for(int b = 0; b < k; b++){
+                int melhorPos = -1, melhorCusto = INT_MAX;
+                if (b == a) continue;
+                for(int pos = 0; pos <= v[b].nParadas; pos++){
+                    int antB = pos > 0 ? v[b].paradas[pos-1] : 0, proxB = pos < v[b].nParadas ? v[b].paradas[pos] : 0;
+                    int c = v[b].custo + DIST(dist, n, antB, s) + DIST(dist, n, s, proxB) - DIST(dist, n, antB, proxB);
+                    if (c < melhorCusto){
+                        melhorCusto = c;
+                        melhorPos = pos;
+                    }
+                }
+                int novoMakespan = makespanVeiculos(v, k, a, custoA, b, melhorCusto);
+                int novoTotal = total - v[a].custo - v[b].custo + custoA + melhorCusto;
+                if (!melhorSolucaoVeiculos(novoMakespan, novoTotal, makespan, total)) continue;
+
+                memmove(&pa[ia], &pa[ia+1], sizeof(int) * (v[a].nParadas - ia - 1));
+                v[a].nParadas--;
+                v[a].custo = custoA;
+                memmove(&v[b].paradas[melhorPos+1], &v[b].paradas[melhorPos], sizeof(int) * (v[b].nParadas - melhorPos));
+                v[b].paradas[melhorPos] = s;
+                v[b].nParadas++;
+                v[b].custo = melhorCusto;
+                makespan = novoMakespan;
+                total = novoTotal;
+                melhorou = 1;
+                ia--; /*a posicao ia agora tem outra parada*/
+                break;
+            }
+        }
+    }
+
+    /*troca*/
+    for(int a = 0; a < k; a++){
+        for(int b = a + 1; b < k; b++){
+            for(int ia = 0; ia < v[a].nParadas; ia++){
+                for(int ib = 0; ib < v[b].nParadas; ib++){
+                    int *pa = v[a].paradas, *pb = v[b].paradas;
+                    int s = pa[ia], t = pb[ib];
+                    int antA = ia > 0 ? pa[ia-1] : 0, proxA = ia < v[a].nParadas - 1 ? pa[ia+1] : 0;
+                    int antB = ib > 0 ? pb[ib-1] : 0, proxB = ib < v[b].nParadas - 1 ? pb[ib+1] : 0;
+                    int custoA = v[a].custo + DIST(dist, n, antA, t) + DIST(dist, n, t, proxA)
+                                            - DIST(dist, n, antA, s) - DIST(dist, n, s, proxA);
+                    int custoB = v[b].custo + DIST(dist, n, antB, s) + DIST(dist, n, s, proxB)
+                                            - DIST(dist, n, antB, t) - DIST(dist, n, t, proxB);
+                    int novoMakespan = makespanVeiculos(v, k, a, custoA, b, custoB);
+                    int novoTotal = total - v[a].custo - v[b].custo + custoA + custoB;
+                    if (!melhorSolucaoVeiculos(novoMakespan, novoTotal, makespan, total)) continue;
+
+                    pa[ia] = t;
+                    pb[ib] = s;
+                    v[a].custo = custoA;
+                    v[b].custo = custoB;
+                    makespan = novoMakespan;
+                    total = novoTotal;
+                    melhorou = 1;
+                }
+            }
+        }
+    }
+    return melhorou;
+}
+
+/*Divide as paradas 1..n-1 da matriz entre k veiculos que saem da casa (0):
+  agrupamento por economias, otimizacao de cada rota (em paralelo com
+  USA_PTHREAD) e movimentos entre rotas ate nao haver melhora.
+  v[r].paradas deve ter espaco para n-1 paradas. Retorna a distancia total,
+  ou -1 se k < 1*/
+int rotasVeiculos(int n, const int *dist, int k, RotaVeiculo v[]){
+    int total = 0;
+
+    if (k < 1) return -1;
+    agrupaEconomias(n, dist, k, v);
+    otimizaVeiculos(n, dist, v, k);
+    for(int iter = 0; iter < 50 && melhoraEntreRotas(n, dist, v, k); iter++){
+        otimizaVeiculos(n, dist, v, k);
+    }
+    for(int r = 0; r < k; r++) total += v[r].custo;
+    return total;
+}
+
+/*Modo com k veiculos saindo de "Minha Casa": imprime a rota de cada veiculo,
+  a distancia total e o makespan (maior rota)*/
+void melhorRotaVeiculos(Vert G[], int ordem, char *lugares[], int nLugares, int k){
+    if (k < 1){
+        fprintf(stderr, "Numero de veiculos invalido: %d\n", k);
+        return;
+    }
+    int *dist = criaMatrizParadas(G, ordem, lugares, nLugares);
+    RotaVeiculo v[k];
+    int total, makespan = 0;
+
+    for(int r = 0; r < k; r++){
+        v[r].paradas = (int*) malloc(sizeof(int) * (nLugares > 0 ? nLugares : 1));
+        if (v[r].paradas == NULL){
+            fprintf(stderr, "Erro de alocacao\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    total = rotasVeiculos(nLugares + 1, dist, k, v);
+
+    printf("Rotas de %d veiculos\n", k);
+    for(int r = 0; r < k; r++){
+        printf("Veiculo %d: Casa", r + 1);
+        for(int i = 0; i < v[r].nParadas; i++) printf(" -> %s", lugares[v[r].paradas[i] - 1]);
+        printf(" -> Casa (%dm)\n", v[r].custo);
+        if (v[r].custo > makespan) makespan = v[r].custo;
+        free(v[r].paradas);
+    }
+    printf("Distancia total = %dm\n", total);
+    printf("Makespan (maior rota) = %dm\n", makespan);
+    free(dist);
+}
+
+/*Relogio de parede quando ha threads (clock() somaria o tempo de todas)*/
+double relogio(void){
+#ifdef USA_PTHREAD
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+#else
+    return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/*Mede o modo com varios veiculos em uma grade com nParadas localidades*/
+void benchmarkVeiculos(int linhas, int colunas, int nParadas, int k){
+    Vert *G = NULL;
+    int ordem, total, makespan = 0;
+    char **lugares = (char**) malloc(sizeof(char*) * nParadas);
+    RotaVeiculo *v = (RotaVeiculo*) malloc(sizeof(RotaVeiculo) * k);
+    int *dist;
+    double t;
+
+    if (lugares == NULL || v == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    geraGrafoGrade(&G, &ordem, linhas, colunas, nParadas, 11);
+    for(int i = 0; i < nParadas; i++){
+        lugares[i] = (char*) malloc(MAX_CHARS);
+        sprintf(lugares[i], "Local %d", i);
+    }
+    for(int r = 0; r < k; r++) v[r].paradas = (int*) malloc(sizeof(int) * nParadas);
+
+    t = relogio();
+    dist = criaMatrizParadas(G, ordem, lugares, nParadas);
+    printf("%d paradas, %d veiculos: matriz de paradas em %.3fs\n", nParadas, k, relogio() - t);
+    t = relogio();
+    total = rotasVeiculos(nParadas + 1, dist, k, v);
+    for(int r = 0; r < k; r++){
+        if (v[r].custo > makespan) makespan = v[r].custo;
+        free(v[r].paradas);
+    }
+    printf("Rotas em %.3fs: total = %dm, makespan = %dm\n", relogio() - t, total, makespan);
+
+    for(int i = 0; i < nParadas; i++) free(lugares[i]);
+    free(lugares);
+    free(v);
+    free(dist);
+    destroiGrafo(&G, ordem);
+}
+
+
+/*Tamanho (2 a 4) da sequencia UTF-8 valida que comeca em p, ou 0 se p nao
+  inicia uma (ASCII, byte de continuacao solto, sequencia truncada ou longa demais)*/
+int tamanhoUTF8(const unsigned char *p){
+    int tam, min = 0x80, max = 0xBF; /*faixa do segundo byte*/
+
+    if (p[0] >= 0xC2 && p[0] <= 0xDF) tam = 2;
+    else if (p[0] >= 0xE0 && p[0] <= 0xEF){
+        tam = 3;
+        if (p[0] == 0xE0) min = 0xA0;      /*forma longa demais*/
+        else if (p[0] == 0xED) max = 0x9F; /*surrogates*/
+    } else if (p[0] >= 0xF0 && p[0] <= 0xF4){
+        tam = 4;
+        if (p[0] == 0xF0) min = 0x90;
+        else if (p[0] == 0xF4) max = 0x8F; /*acima de U+10FFFF*/
+    } else return 0;
+    if (p[1] < min || p[1] > max) return 0;
+    for(int i = 2; i < tam; i++){
+        if (p[i] < 0x80 || p[i] > 0xBF) return 0;
+    }
+    return tam;
+}
+
+/*Normaliza um nome para busca: remove acentos (UTF-8 ou Latin-1), passa para
+  minusculas, troca pontuacao por espaco e elimina espacos repetidos. As
+  demais sequencias UTF-8 (espaco nao separavel, travessao, letras fora do
+  Latin-1) contam inteiras como separador; a tabela Latin-1 so vale para
+  bytes soltos que nao formam UTF-8 valido*/
+void normalizaNome(const char *entrada, char saida[MAX_CHARS]){
+    static const char semAcento[] = /*codigos 0xC0..0xFF*/
+        "AAAAAAACEEEEIIIIDNOOOOO OUUUUYTsaaaaaaaceeeeiiiidnooooo ouuuuyty";
+    const unsigned char *p = (const unsigned char*) entrada;
+    int n = 0, espaco = 1;
+
+    while(*p != '\0' && n < MAX_CHARS - 1){
+        int c = *p, tam = tamanhoUTF8(p);
+        if (tam == 2 && c == 0xC3){
+            c = semAcento[p[1] + 0x40 - 0xC0]; /*UTF-8 de U+00C0..U+00FF*/
+        } else if (tam > 0){
+            c = ' ';
+        } else {
+            tam = 1;
+            if (c >= 0xC0) c = semAcento[c - 0xC0];
+        }
+        p += tam;
+        if (c < 128 && isalnum(c)){
+            saida[n++] = (char) tolower(c);
+            espaco = 0;
+        } else if (!espaco){
+            saida[n++] = ' ';
+            espaco = 1;
+        }
+    }
+    if (n > 0 && saida[n-1] == ' ') n--;
+    saida[n] = '\0';
+}
+
+/*Codigo de um simbolo do alfabeto normalizado*/
+int simboloTrigrama(char c){
+    if (c >= 'a' && c <= 'z') return c - 'a' + 1;
+    if (c >= '0' && c <= '9') return c - '0' + 27;
+    return 0;
+}
+
+/*Trigramas distintos de um nome normalizado, com um espaco de cada lado.
+  Retorna a quantidade preenchida em codigos[] (no maximo MAX_CHARS)*/
+int trigramasNome(const char *normalizado, int codigos[]){
+    char s[MAX_CHARS + 2];
+    int n = 0, len;
+
+    if (normalizado[0] == '\0') return 0;
+    sprintf(s, " %s ", normalizado);
+    len = (int) strlen(s);
+    for(int i = 0; i + 2 < len; i++){
+        int t = (simboloTrigrama(s[i]) * TAM_ALFABETO_TRIGRAMA + simboloTrigrama(s[i+1]))
+                * TAM_ALFABETO_TRIGRAMA + simboloTrigrama(s[i+2]);
+        int repetido = 0;
+        for(int j = 0; j < n && !repetido; j++) repetido = (codigos[j] == t);
+        if (!repetido) codigos[n++] = t;
+    }
+    return n;
+}
+
+/*Distancia de edicao (Levenshtein) com duas linhas*/
+int distanciaEdicao(const char *a, const char *b){
+    int la = (int) strlen(a), lb = (int) strlen(b);
+    int anterior[MAX_CHARS + 1], atual[MAX_CHARS + 1];
+
+    for(int j = 0; j <= lb; j++) anterior[j] = j;
+    for(int i = 1; i <= la; i++){
+        atual[0] = i;
+        for(int j = 1; j <= lb; j++){
+            int d = anterior[j-1] + (a[i-1] != b[j-1]);
+            if (anterior[j] + 1 < d) d = anterior[j] + 1;
+            if (atual[j-1] + 1 < d) d = atual[j-1] + 1;
+            atual[j] = d;
+        }
+        memcpy(anterior, atual, sizeof(int) * (lb + 1));
+    }
+    return anterior[lb];
+}
+
+/*Realoca um vetor dobrando a capacidade quando cheio*/
+void *garanteCapacidade(void *vetor, int *capacidade, int necessario, size_t tamanho){
+    if (necessario <= *capacidade) return vetor;
+    while(*capacidade < necessario) *capacidade = (*capacidade == 0) ? 4 : 2 * *capacidade;
+    vetor = realloc(vetor, tamanho * *capacidade);
+    if (vetor == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    return vetor;
+}
+
+/*Cria indice vazio*/
+IndiceLocalidades *criaIndiceLocalidades(void){
+    IndiceLocalidades *ind = (IndiceLocalidades*) calloc(1, sizeof(IndiceLocalidades));
+
+    if (ind == NULL) return NULL;
+    ind->listas = (int**) calloc(NUM_TRIGRAMAS, sizeof(int*));
+    ind->tamLista = (int*) calloc(NUM_TRIGRAMAS, sizeof(int));
+    ind->capLista = (int*) calloc(NUM_TRIGRAMAS, sizeof(int));
+    ind->posConsulta = (unsigned char*) calloc(NUM_TRIGRAMAS, 1);
+    if (ind->listas == NULL || ind->tamLista == NULL || ind->capLista == NULL || ind->posConsulta == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    ind->nos = (NoTrie*) garanteCapacidade(NULL, &ind->capNos, 1, sizeof(NoTrie));
+    ind->nos[0].c = '\0';
+    ind->nos[0].filho = ind->nos[0].irmao = ind->nos[0].nome = -1;
+    ind->nNos = 1;
+    return ind;
+}
+
+/*Libera o indice e os nomes armazenados*/
+void destroiIndiceLocalidades(IndiceLocalidades **ind){
+    if (*ind == NULL) return;
+    for(int i = 0; i < (*ind)->nNomes; i++) free((*ind)->nomes[i]);
+    for(int t = 0; t < NUM_TRIGRAMAS; t++) free((*ind)->listas[t]);
+    free((*ind)->nomes);
+    free((*ind)->nos);
+    free((*ind)->listas);
+    free((*ind)->tamLista);
+    free((*ind)->capLista);
+    free((*ind)->contagem);
+    free((*ind)->tocados);
+    free((*ind)->posConsulta);
+    free(*ind);
+    *ind = NULL;
+}
+
+/*Desce na trie pelo nome normalizado; com cria != 0 insere os nos que
+  faltam (mantendo irmaos em ordem). Retorna o no final ou -1*/
+int desceTrie(IndiceLocalidades *ind, const char *normalizado, int cria){
+    int no = 0;
+
+    for(const char *p = normalizado; *p != '\0'; p++){
+        int anterior = -1, f = ind->nos[no].filho;
+        while(f != -1 && ind->nos[f].c < *p){
+            anterior = f;
+            f = ind->nos[f].irmao;
+        }
+        if (f == -1 || ind->nos[f].c != *p){
+            int novo;
+            if (!cria) return -1;
+            ind->nos = (NoTrie*) garanteCapacidade(ind->nos, &ind->capNos, ind->nNos + 1, sizeof(NoTrie));
+            novo = ind->nNos++;
+            ind->nos[novo].c = *p;
+            ind->nos[novo].filho = -1;
+            ind->nos[novo].irmao = f;
+            ind->nos[novo].nome = -1;
+            if (anterior == -1) ind->nos[no].filho = novo;
+            else ind->nos[anterior].irmao = novo;
+            f = novo;
+        }
+        no = f;
+    }
+    return no;
+}
+
+/*Acrescenta um nome ao indice; nomes iguais apos normalizacao sao mantidos
+  uma unica vez. Retorna o indice do nome*/
+int acrescentaNomeIndice(IndiceLocalidades *ind, const char *nome){
+    char normalizado[MAX_CHARS];
+    int codigos[MAX_CHARS];
+    int no, id, nTrigramas;
+
+    normalizaNome(nome, normalizado);
+    no = desceTrie(ind, normalizado, 1);
+    if (ind->nos[no].nome != -1) return ind->nos[no].nome;
+
+    id = ind->nNomes++;
+    ind->nos[no].nome = id;
+    ind->nomes = (char**) garanteCapacidade(ind->nomes, &ind->capNomes, ind->nNomes, sizeof(char*));
+    ind->nomes[id] = (char*) malloc(strlen(nome) + 1);
+    if (ind->nomes[id] == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(ind->nomes[id], nome);
+
+    nTrigramas = trigramasNome(normalizado, codigos);
+    for(int i = 0; i < nTrigramas; i++){
+        int t = codigos[i];
+        ind->listas[t] = (int*) garanteCapacidade(ind->listas[t], &ind->capLista[t], ind->tamLista[t] + 1, sizeof(int));
+        ind->listas[t][ind->tamLista[t]++] = id;
+    }
+    return id;
+}
+
+/*Indexa todas as localidades das arestas do grafo*/
+void indexaLocalidades(IndiceLocalidades *ind, Vert G[], int ordem){
+    Aresta *aux;
+
+    for(int i = 0; i < ordem; i++){
+        for(aux = G[i].prim; aux != NULL; aux = aux->prox){
+            if (aux->localidade.nome[0] != '\0') acrescentaNomeIndice(ind, aux->localidade.nome);
+        }
+    }
+}
+
+/*Busca exata apos normalizacao. Retorna o indice do nome ou -1*/
+int buscaExataIndice(IndiceLocalidades *ind, const char *entrada){
+    char normalizado[MAX_CHARS];
+    int no;
+
+    normalizaNome(entrada, normalizado);
+    no = desceTrie(ind, normalizado, 0);
+    return (no == -1) ? -1 : ind->nos[no].nome;
+}
+
+/*Coleta em ordem alfabetica os nomes da subarvore de no*/
+void coletaTrie(IndiceLocalidades *ind, int no, int resultados[], int *n, int max){
+    if (*n >= max) return;
+    if (ind->nos[no].nome != -1) resultados[(*n)++] = ind->nos[no].nome;
+    for(int f = ind->nos[no].filho; f != -1 && *n < max; f = ind->nos[f].irmao){
+        coletaTrie(ind, f, resultados, n, max);
+    }
+}
+
+/*Autocompletar: ate max nomes que comecam com o prefixo (normalizado).
+  Retorna a quantidade preenchida em resultados[]*/
+int completaPrefixo(IndiceLocalidades *ind, const char *prefixo, int resultados[], int max){
+    char normalizado[MAX_CHARS];
+    int no, n = 0;
+
+    normalizaNome(prefixo, normalizado);
+    no = desceTrie(ind, normalizado, 0);
+    if (no != -1) coletaTrie(ind, no, resultados, &n, max);
+    return n;
+}
+
+/*Seleciona em saida[] os max nomes de ids[] com maior contagem (ordem
+  decrescente; empates na ordem de ids[]). As contagens vao de 0 a MAX_CHARS,
+  entao basta uma distribuicao por contagem em duas passadas*/
+int selecionaMaisComuns(IndiceLocalidades *ind, const int ids[], int nIds, int saida[], int max){
+    int quantos[MAX_CHARS + 1], pos[MAX_CHARS + 1], fim[MAX_CHARS + 1];
+    int n = 0;
+
+    for(int c = 0; c <= MAX_CHARS; c++) quantos[c] = 0;
+    for(int i = 0; i < nIds; i++) quantos[ind->contagem[ids[i]].comuns]++;
+    for(int c = MAX_CHARS; c >= 0; c--){
+        pos[c] = n;
+        n += quantos[c];
+        if (n > max) n = max;
+        fim[c] = n;
+    }
+    for(int i = 0; i < nIds; i++){
+        int c = ind->contagem[ids[i]].comuns;
+        if (pos[c] < fim[c]) saida[pos[c]++] = ids[i];
+    }
+    return n;
+}
+
+/*Quantos trigramas distintos do nome estao entre os nQ da consulta marcados
+  em posConsulta[]. Preenche normalizado e, se nT != NULL, *nT com o total de
+  trigramas do nome*/
+int trigramasEmComum(const unsigned char posConsulta[], int nQ, const char *nome, char normalizado[MAX_CHARS], int *nT){
+    char s[MAX_CHARS + 2], achado[MAX_CHARS];
+    int comuns = 0, len;
+
+    normalizaNome(nome, normalizado);
+    if (nT != NULL){
+        int codigos[MAX_CHARS];
+        *nT = trigramasNome(normalizado, codigos);
+    }
+    if (normalizado[0] == '\0') return 0;
+    s[0] = ' ';
+    strcpy(s + 1, normalizado);
+    len = (int) strlen(s);
+    s[len++] = ' ';
+    memset(achado, 0, nQ);
+    for(int i = 0; i + 2 < len; i++){
+        int t = (simboloTrigrama(s[i]) * TAM_ALFABETO_TRIGRAMA + simboloTrigrama(s[i+1]))
+                * TAM_ALFABETO_TRIGRAMA + simboloTrigrama(s[i+2]);
+        int k = posConsulta[t];
+        if (k != 0 && !achado[k-1]){
+            achado[k-1] = 1;
+            comuns++;
+        }
+    }
+    return comuns;
+}
+
+/*Busca aproximada em tres etapas: (1) conta trigramas em comum lendo as
+  listas da mais curta para a mais longa enquanto o total lido nao passar de
+  LIMITE_LEITURA_FUZZY (da mais curta le no maximo esse tanto, o que basta
+  para palavras comuns que aparecem em milhares de nomes); (2) recalcula a
+  contagem dos MAX_PRE_CANDIDATOS melhores a partir dos trigramas do proprio
+  nome, sem percorrer as listas longas; (3) reavalia os MAX_CANDIDATOS_FUZZY
+  melhores pelo coeficiente de Dice e pela distancia de edicao. Preenche
+  cand[] do mais para o menos parecido e retorna a quantidade*/
+int buscaAproximada(IndiceLocalidades *ind, const char *entrada, CandidatoLocalidade cand[], int max){
+    char q[MAX_CHARS];
+    int codigos[MAX_CHARS];
+    int pre[MAX_PRE_CANDIDATOS], melhores[MAX_CANDIDATOS_FUZZY];
+    int nQ, nTocados = 0, nPre, nMelhores, n = 0, lidas;
+    long lidos = 0;
+
+    normalizaNome(entrada, q);
+    nQ = trigramasNome(q, codigos);
+    if (nQ == 0 || ind->nNomes == 0) return 0;
+
+    /*contadores por nome, zerados sob demanda via marca*/
+    if (ind->contagem == NULL || ind->capTocados < ind->nNomes){
+        ind->capTocados = ind->nNomes;
+        ind->contagem = (ContagemNome*) realloc(ind->contagem, sizeof(ContagemNome) * ind->capTocados);
+        ind->tocados = (int*) realloc(ind->tocados, sizeof(int) * ind->capTocados);
+        if (ind->contagem == NULL || ind->tocados == NULL){
+            fprintf(stderr, "Erro de alocacao\n");
+            exit(EXIT_FAILURE);
+        }
+        for(int i = 0; i < ind->capTocados; i++) ind->contagem[i].marca = 0;
+        ind->consulta = 0;
+    }
+    ind->consulta++;
+
+    /*ordena os trigramas da consulta pelo tamanho da lista*/
+    for(int i = 1; i < nQ; i++){
+        int t = codigos[i], k = i;
+        while(k > 0 && ind->tamLista[codigos[k-1]] > ind->tamLista[t]){
+            codigos[k] = codigos[k-1];
+            k--;
+        }
+        codigos[k] = t;
+    }
+    for(lidas = 0; lidas < nQ; lidas++){
+        int t = codigos[lidas];
+        int tam = ind->tamLista[t];
+        lidos += tam;
+        if (lidos > LIMITE_LEITURA_FUZZY && lidas > 0) break;
+        if (tam > LIMITE_LEITURA_FUZZY) tam = LIMITE_LEITURA_FUZZY;
+        for(int j = 0; j < tam; j++){
+            int id = ind->listas[t][j];
+            ContagemNome *cn = &ind->contagem[id];
+            if (cn->marca != ind->consulta){
+                cn->marca = ind->consulta;
+                cn->comuns = 0;
+                ind->tocados[nTocados++] = id;
+            }
+            cn->comuns++;
+        }
+    }
+
+    for(int i = 0; i < nQ; i++) ind->posConsulta[codigos[i]] = (unsigned char)(i + 1);
+    nPre = selecionaMaisComuns(ind, ind->tocados, nTocados, pre, MAX_PRE_CANDIDATOS);
+    if (lidas < nQ){
+        for(int i = 0; i < nPre; i++){
+            char t[MAX_CHARS];
+            ind->contagem[pre[i]].comuns = trigramasEmComum(ind->posConsulta, nQ, ind->nomes[pre[i]], t, NULL);
+        }
+    }
+    nMelhores = selecionaMaisComuns(ind, pre, nPre, melhores, MAX_CANDIDATOS_FUZZY);
+
+    /*reavaliacao exata: Dice sobre todos os trigramas e distancia de edicao*/
+    for(int i = 0; i < nMelhores; i++){
+        char t[MAX_CHARS];
+        int nT, comuns, k;
+        CandidatoLocalidade c;
+
+        comuns = trigramasEmComum(ind->posConsulta, nQ, ind->nomes[melhores[i]], t, &nT);
+        c.nome = melhores[i];
+        c.similaridade = 2.0 * comuns / (nQ + nT);
+        if (n == max && c.similaridade < cand[n-1].similaridade) continue; /*nao entra: dispensa a edicao*/
+        c.edicao = distanciaEdicao(q, t);
+
+        /*insere ordenado: maior similaridade, depois menor edicao*/
+        if (n == max){
+            CandidatoLocalidade *ult = &cand[n-1];
+            if (c.similaridade < ult->similaridade ||
+                (c.similaridade == ult->similaridade && c.edicao >= ult->edicao)) continue;
+            n--;
+        }
+        k = n++;
+        while(k > 0 && (cand[k-1].similaridade < c.similaridade ||
+                        (cand[k-1].similaridade == c.similaridade && cand[k-1].edicao > c.edicao))){
+            cand[k] = cand[k-1];
+            k--;
+        }
+        cand[k] = c;
+    }
+    for(int i = 0; i < nQ; i++) ind->posConsulta[codigos[i]] = 0;
+    return n;
+}
+
+/*Converte a entrada do usuario no nome da localidade como esta no grafo:
+  busca exata normalizada e, se falhar, o candidato mais parecido com
+  similaridade >= SIMILARIDADE_MINIMA. Retorna NULL se nada for aceitavel*/
+char *resolveLocalidade(IndiceLocalidades *ind, const char *entrada){
+    CandidatoLocalidade c;
+    int id = buscaExataIndice(ind, entrada);
+
+    if (id != -1) return ind->nomes[id];
+    if (buscaAproximada(ind, entrada, &c, 1) == 1 && c.similaridade >= SIMILARIDADE_MINIMA){
+        return ind->nomes[c.nome];
+    }
+    return NULL;
+}
+
+int comparaTempo(const void *a, const void *b){
+    double x = *(const double*) a, y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+/*Mede construcao e consultas do indice com nNomes nomes sinteticos (com
+  acentos) e consultas sem acento, com letras trocadas ou so o prefixo.
+  Os nomes diferem muitas vezes so pelo numero, o pior caso para trigramas.
+  A latencia (p50/p99) da busca aproximada e medida tambem com consultas
+  realistas: so o tipo ("padaria"), tipo e bairro, tipo, bairro e numero
+  qualquer, e nomes com letras trocadas*/
+void benchmarkIndiceLocalidades(int nNomes, int nConsultas){
+    static const char *tipos[] = {"Padaria", "Farmácia", "Mercado", "Escola", "Açougue", "Pão de Açúcar",
+                                  "Pizzaria", "Hospital", "Estação", "Praça", "Posto", "Clínica",
+                                  "Livraria", "Lavanderia", "Academia", "Café", "Restaurante", "Banco",
+                                  "Igreja", "Teatro"};
+    static const char *bairros[] = {"Higienópolis", "Consolação", "São João", "Pacaembu", "Perdizes",
+                                    "Jardins", "Bela Vista", "Liberdade", "Sé", "República",
+                                    "Santa Cecília", "Vila Buarque", "Pinheiros", "Butantã", "Moóca",
+                                    "Ipiranga", "Lapa", "Tatuapé", "Penha", "Santana", "Sumaré",
+                                    "Aclimação", "Cambuci", "Brás", "Barra Funda"};
+    int nTipos = sizeof(tipos) / sizeof(tipos[0]), nBairros = sizeof(bairros) / sizeof(bairros[0]);
+    IndiceLocalidades *ind = criaIndiceLocalidades();
+    char nome[MAX_CHARS], consulta[MAX_CHARS];
+    CandidatoLocalidade cand[5];
+    int resultados[10];
+    static const char *normalizacao[][2] = { /*entrada e resultado esperado*/
+        {"Caf\xC3\xA9\xC2\xA0" "Bar", "cafe bar"},         /*espaco nao separavel*/
+        {"Posto \xE2\x80\x93 Shell", "posto shell"},       /*travessao*/
+        {"\xC5\x81odz", "odz"},                             /*letra fora do Latin-1*/
+        {"Caf\xE9 S\xE3o Jo\xE3o", "cafe sao joao"},        /*Latin-1*/
+        {"A\xC3\xA7ougue \xF0\x9F\x8D\x95 24h", "acougue 24h"}
+    };
+    int nNormalizacao = sizeof(normalizacao) / sizeof(normalizacao[0]), normalizados = 0;
+    int acertos = 0, entreCinco = 0;
+    long memoria;
+    clock_t t;
+    double tExata = 0, tPrefixo = 0, tFuzzy = 0;
+
+    for(int i = 0; i < nNormalizacao; i++){
+        normalizaNome(normalizacao[i][0], consulta);
+        if (strcmp(consulta, normalizacao[i][1]) == 0) normalizados++;
+        else printf("Normalizacao divergente: \"%s\", esperado \"%s\"\n", consulta, normalizacao[i][1]);
+    }
+    printf("Normalizacao: %d/%d nomes como esperado\n", normalizados, nNormalizacao);
+
+    t = clock();
+    for(int i = 0; i < nNomes; i++){
+        sprintf(nome, "%s %s %d", tipos[i % nTipos], bairros[(i / nTipos) % nBairros], i / (nTipos * nBairros) + 1);
+        acrescentaNomeIndice(ind, nome);
+    }
+    memoria = (long) sizeof(NoTrie) * ind->capNos + (long) sizeof(char*) * ind->capNomes;
+    for(int i = 0; i < ind->nNomes; i++) memoria += (long) strlen(ind->nomes[i]) + 1;
+    for(int k = 0; k < NUM_TRIGRAMAS; k++) memoria += (long) sizeof(int) * ind->capLista[k];
+    printf("Indice com %d nomes: %.3fs, %d nos na trie, ~%ldMB\n", ind->nNomes,
+           (double)(clock() - t) / CLOCKS_PER_SEC, ind->nNos, memoria >> 20);
+
+    srand(3);
+    for(int q = 0; q < nConsultas; q++){
+        int id = rand() % ind->nNomes, len, p, n;
+        normalizaNome(ind->nomes[id], consulta); /*sem acentos e em minusculas*/
+
+        t = clock();
+        if (buscaExataIndice(ind, consulta) != id) printf("Busca exata falhou: %s\n", consulta);
+        tExata += clock() - t;
+
+        len = (int) strlen(consulta);
+        consulta[len < 8 ? len : 8] = '\0';
+        t = clock();
+        completaPrefixo(ind, consulta, resultados, 10);
+        tPrefixo += clock() - t;
+
+        /*troca duas letras vizinhas distintas (trocar digitos geraria outro nome valido)*/
+        normalizaNome(ind->nomes[id], consulta);
+        do {
+            p = rand() % (len - 1);
+        } while(!isalpha((unsigned char) consulta[p]) || !isalpha((unsigned char) consulta[p+1]) ||
+                consulta[p] == consulta[p+1]);
+        {
+            char x = consulta[p];
+            consulta[p] = consulta[p+1];
+            consulta[p+1] = x;
+        }
+        t = clock();
+        n = buscaAproximada(ind, consulta, cand, 5);
+        tFuzzy += clock() - t;
+        for(int k = 0; k < n; k++){
+            if (cand[k].nome != id) continue;
+            acertos += (k == 0);
+            entreCinco++;
+        }
+    }
+    printf("Busca exata:      %.4fms/consulta\n", 1000.0 * tExata / CLOCKS_PER_SEC / nConsultas);
+    printf("Prefixo (10):     %.4fms/consulta\n", 1000.0 * tPrefixo / CLOCKS_PER_SEC / nConsultas);
+    printf("Aproximada (5):   %.4fms/consulta, nome certo em 1o: %d/%d, entre os 5: %d/%d\n",
+           1000.0 * tFuzzy / CLOCKS_PER_SEC / nConsultas, acertos, nConsultas, entreCinco, nConsultas);
+
+    {
+        double *tempos = (double*) malloc(sizeof(double) * nConsultas);
+        if (tempos == NULL){
+            fprintf(stderr, "Erro de alocacao\n");
+            exit(EXIT_FAILURE);
+        }
+        for(int q = 0; q < nConsultas; q++){
+            switch(q % 4){
+            case 0:
+                normalizaNome(tipos[rand() % nTipos], consulta);
+                break;
+            case 1:
+                sprintf(nome, "%s %s", tipos[rand() % nTipos], bairros[rand() % nBairros]);
+                normalizaNome(nome, consulta);
+                break;
+            case 2:
+                sprintf(nome, "%s %s %d", tipos[rand() % nTipos], bairros[rand() % nBairros], 1 + rand() % 2000);
+                normalizaNome(nome, consulta);
+                break;
+            default: {
+                int p, len;
+                normalizaNome(ind->nomes[rand() % ind->nNomes], consulta);
+                len = (int) strlen(consulta);
+                p = rand() % (len - 1);
+                char x = consulta[p];
+                consulta[p] = consulta[p+1];
+                consulta[p+1] = x;
+            }
+            }
+            t = clock();
+            buscaAproximada(ind, consulta, cand, 5);
+            tempos[q] = 1000.0 * (clock() - t) / CLOCKS_PER_SEC;
+        }
+        qsort(tempos, nConsultas, sizeof(double), comparaTempo);
+        printf("Aproximada, consultas realistas: p50 %.3fms, p99 %.3fms, maximo %.3fms\n",
+               tempos[nConsultas / 2], tempos[nConsultas * 99 / 100], tempos[nConsultas - 1]);
+        free(tempos);
+    }
+    destroiIndiceLocalidades(&ind);
+}
+
+
+/*Grava um inteiro sem sinal como varint (7 bits por byte). Retorna os bytes usados*/
+int gravaVarint(unsigned char *p, unsigned int x){
+    int n = 0;
+    while(x >= 0x80){
+        p[n++] = (unsigned char)(x | 0x80);
+        x >>= 7;
+    }
+    p[n++] = (unsigned char) x;
+    return n;
+}
+
+/*Le um varint e avanca *p*/
+unsigned int leVarint(const unsigned char **p){
+    unsigned int x = 0;
+    int desloc = 0;
+    while(**p & 0x80){
+        x |= (unsigned int)(*(*p)++ & 0x7F) << desloc;
+        desloc += 7;
+    }
+    return x | ((unsigned int)(*(*p)++) << desloc);
+}
+
+/* Semi-aresta usada para ordenar os vizinhos na construcao do grafo compacto */
+typedef struct {
+	int vizinho;
+	int dist;
+} VizinhoCompacto;
+
+int comparaVizinho(const void *a, const void *b){
+    return ((const VizinhoCompacto*) a)->vizinho - ((const VizinhoCompacto*) b)->vizinho;
+}
+
+/*Constroi a representacao compacta a partir das listas de adjacencia*/
+void criaGrafoCompacto(Vert G[], int ordem, GrafoCompacto *gc){
+    int maiorGrau = 0, maiorDist = 0, e = 0, l = 0;
+    size_t bytes = 0, nome = 0;
+    VizinhoCompacto *viz;
+    Aresta *aux;
+
+    gc->ordem = ordem;
+    gc->nArestas = 0;
+    gc->nLocalidades = 0;
+    gc->bytesNomes = 0;
+    for(int v = 0; v < ordem; v++){
+        int grau = 0;
+        for(aux = G[v].prim; aux != NULL; aux = aux->prox){
+            grau++;
+            if (aux->dist_prox > maiorDist) maiorDist = aux->dist_prox;
+            /*cada localidade vem da semi-aresta do maior extremo, a mesma que dijkstra() usa*/
+            if (aux->localidade.nome[0] != '\0' && v >= aux->extremo2){
+                gc->nLocalidades++;
+                gc->bytesNomes += strlen(aux->localidade.nome) + 1;
+            }
+        }
+        gc->nArestas += grau;
+        if (grau > maiorGrau) maiorGrau = grau;
+    }
+
+    gc->inicio = (unsigned int*) malloc(sizeof(unsigned int) * (ordem + 1));
+    gc->primeira = (unsigned int*) malloc(sizeof(unsigned int) * (ordem + 1));
+    gc->vizinhos = (unsigned char*) malloc(5 * (size_t) gc->nArestas + 1); /*pior caso do varint*/
+    gc->peso16 = NULL;
+    gc->peso32 = NULL;
+    if (maiorDist <= USHRT_MAX) gc->peso16 = (unsigned short*) malloc(sizeof(unsigned short) * (gc->nArestas + 1));
+    else gc->peso32 = (unsigned int*) malloc(sizeof(unsigned int) * (gc->nArestas + 1));
+    gc->localidades = (LocalidadeCompacta*) malloc(sizeof(LocalidadeCompacta) * (gc->nLocalidades + 1));
+    gc->nomes = (char*) malloc(gc->bytesNomes + 1);
+    viz = (VizinhoCompacto*) malloc(sizeof(VizinhoCompacto) * (maiorGrau + 1));
+    if (gc->inicio == NULL || gc->primeira == NULL || gc->vizinhos == NULL ||
+        (gc->peso16 == NULL && gc->peso32 == NULL) || gc->localidades == NULL ||
+        gc->nomes == NULL || viz == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for(int v = 0; v < ordem; v++){
+        int grau = 0, anterior = v;
+        for(aux = G[v].prim; aux != NULL; aux = aux->prox){
+            viz[grau].vizinho = aux->extremo2;
+            viz[grau].dist = aux->dist_prox;
+            grau++;
+            if (aux->localidade.nome[0] != '\0' && v >= aux->extremo2){
+                LocalidadeCompacta *lc = &gc->localidades[l++];
+                lc->nome = gc->nomes + nome;
+                strcpy(lc->nome, aux->localidade.nome);
+                nome += strlen(aux->localidade.nome) + 1;
+                lc->v1 = v;
+                lc->v2 = aux->extremo2;
+                lc->d1 = aux->localidade.distancia_v;
+                lc->d2 = aux->dist_prox - aux->localidade.distancia_v;
+            }
+        }
+        qsort(viz, grau, sizeof(VizinhoCompacto), comparaVizinho);
+
+        gc->inicio[v] = (unsigned int) bytes;
+        gc->primeira[v] = (unsigned int) e;
+        for(int i = 0; i < grau; i++){
+            int delta = viz[i].vizinho - anterior;
+            /*primeiro vizinho em zigzag (pode ser menor que v); demais >= 0*/
+            unsigned int codigo = (i == 0) ? ((unsigned int) delta << 1) ^ -(unsigned int)(delta < 0) : (unsigned int) delta;
+            bytes += gravaVarint(gc->vizinhos + bytes, codigo);
+            if (gc->peso16 != NULL) gc->peso16[e] = (unsigned short) viz[i].dist;
+            else gc->peso32[e] = (unsigned int) viz[i].dist;
+            anterior = viz[i].vizinho;
+            e++;
+        }
+    }
+    gc->inicio[ordem] = (unsigned int) bytes;
+    gc->primeira[ordem] = (unsigned int) e;
+    /*devolve a folga reservada para o pior caso do varint*/
+    gc->vizinhos = (unsigned char*) realloc(gc->vizinhos, bytes + 1);
+    free(viz);
+}
+
+void destroiGrafoCompacto(GrafoCompacto *gc){
+    free(gc->inicio);
+    free(gc->primeira);
+    free(gc->vizinhos);
+    free(gc->peso16);
+    free(gc->peso32);
+    free(gc->localidades);
+    free(gc->nomes);
+    gc->inicio = gc->primeira = gc->peso32 = NULL;
+    gc->vizinhos = NULL;
+    gc->peso16 = NULL;
+    gc->localidades = NULL;
+    gc->nomes = NULL;
+}
+
+/*Localidade no grafo compacto ou NULL*/
+const LocalidadeCompacta *localidadeCompacta(const GrafoCompacto *gc, const char *nome){
+    for(int i = 0; i < gc->nLocalidades; i++){
+        if (strcmp(gc->localidades[i].nome, nome) == 0) return &gc->localidades[i];
+    }
+    return NULL;
+}
+
+/*dijkstra() sobre o grafo compacto, decodificando vizinhos e distancias na
+  relaxacao. dist[], pai[] e cor[] (ordem posicoes) sao do chamador. Retorna
+  a distancia com a mesma convencao de sinal de dijkstra(): negativa quando o
+  melhor extremo do destino e v1, positiva quando e v2; INT_MAX se alguma
+  localidade nao existe*/
+int dijkstraCompacto(const GrafoCompacto *gc, const char *origem, const char *destino,
+                     int dist[], int pai[], char cor[]){
+    const LocalidadeCompacta *o = localidadeCompacta(gc, origem);
+    const LocalidadeCompacta *d = localidadeCompacta(gc, destino);
+    int verticeAtual, distancia1, distancia2;
+
+    if (o == NULL || d == NULL) return INT_MAX;
+    for(int i = 0; i < gc->ordem; i++){
+        dist[i] = INT_MAX;
+        pai[i] = -1;
+        cor[i] = BRANCO;
+    }
+    dist[o->v1] = o->d1;
+    dist[o->v2] = o->d2;
+    pai[o->v1] = pai[o->v2] = -2;
+
+    for(;;){
+        const unsigned char *p;
+        int menor = INT_MAX, vizinho;
+        verticeAtual = -1;
+        for(int i = 1; i < gc->ordem; i++){
+            if (cor[i] != PRETO && dist[i] < menor){
+                menor = dist[i];
+                verticeAtual = i;
+            }
+        }
+        if (verticeAtual == -1) break;
+
+        p = gc->vizinhos + gc->inicio[verticeAtual];
+        vizinho = verticeAtual;
+        for(unsigned int e = gc->primeira[verticeAtual]; e < gc->primeira[verticeAtual + 1]; e++){
+            unsigned int codigo = leVarint(&p);
+            int peso = (gc->peso16 != NULL) ? gc->peso16[e] : (int) gc->peso32[e];
+            if (e == gc->primeira[verticeAtual]) vizinho += (int)(codigo >> 1) ^ -(int)(codigo & 1);
+            else vizinho += (int) codigo;
+            if (dist[vizinho] > menor + peso){
+                dist[vizinho] = menor + peso;
+                pai[vizinho] = verticeAtual;
+            }
+        }
+        cor[verticeAtual] = PRETO;
+    }
+
+    distancia1 = (dist[d->v1] == INT_MAX) ? INT_MAX : dist[d->v1] + d->d1;
+    distancia2 = (dist[d->v2] == INT_MAX) ? INT_MAX : dist[d->v2] + d->d2;
+    return (distancia1 < distancia2) ? -distancia1 : distancia2;
+}
+
+/*Imprime bytes por vertice, por semi-aresta e por localidade nas listas de
+  adjacencia (Vert/Aresta) e no grafo compacto (gc pode ser NULL)*/
+void relatorioMemoria(Vert G[], int ordem, const GrafoCompacto *gc){
+    long nArestas = 0, nLocalidades = 0, bytesNomes = 0;
+    Aresta *aux;
+
+    for(int v = 0; v < ordem; v++){
+        for(aux = G[v].prim; aux != NULL; aux = aux->prox){
+            nArestas++;
+            if (aux->localidade.nome[0] != '\0' && v >= aux->extremo2) nLocalidades++;
+        }
+    }
+    printf("Memoria: %d vertices, %ld semi-arestas, %ld localidades\n", ordem, nArestas, nLocalidades);
+    printf("Listas de adjacencia:\n");
+    printf("  por vertice:     %3d bytes (Vert, com dist/pai/cor das consultas)\n", (int) sizeof(Vert));
+    printf("  por semi-aresta: %3d bytes (Aresta, sem contar o cabecalho do malloc)\n", (int) sizeof(Aresta));
+    printf("  por localidade:  %3d bytes (Localidade embutida em cada semi-aresta)\n", (int)(2 * sizeof(Localidade)));
+    printf("  total:           %ld bytes\n", (long) sizeof(Vert) * ordem + (long) sizeof(Aresta) * nArestas);
+    if (gc == NULL) return;
+
+    for(int i = 0; i < gc->nLocalidades; i++) bytesNomes += (long) strlen(gc->localidades[i].nome) + 1;
+    {
+        long bytesVertice = 2 * sizeof(unsigned int);
+        long bytesPeso = (gc->peso16 != NULL) ? sizeof(unsigned short) : sizeof(unsigned int);
+        long bytesVizinhos = gc->inicio[gc->ordem];
+        long bytesLocalidades = (long) sizeof(LocalidadeCompacta) * gc->nLocalidades + bytesNomes;
+        printf("Grafo compacto (pesos de %d bits):\n", (int)(8 * bytesPeso));
+        printf("  por vertice:     %3ld bytes (+%d por consulta: dist, pai, cor)\n",
+               bytesVertice, (int)(2 * sizeof(int) + sizeof(char)));
+        printf("  por semi-aresta: %6.2f bytes (%.2f de vizinho varint + %ld de peso)\n",
+               gc->nArestas ? (double) bytesVizinhos / gc->nArestas + bytesPeso : 0.0,
+               gc->nArestas ? (double) bytesVizinhos / gc->nArestas : 0.0, bytesPeso);
+        printf("  por localidade:  %6.2f bytes\n",
+               gc->nLocalidades ? (double) bytesLocalidades / gc->nLocalidades : 0.0);
+        printf("  total:           %ld bytes\n", bytesVertice * (gc->ordem + 1) + bytesVizinhos +
+               bytesPeso * gc->nArestas + bytesLocalidades);
+    }
+}
+
+/*Compara memoria e tempo de dijkstra() e dijkstraCompacto() em uma grade*/
+void benchmarkGrafoCompacto(int linhas, int colunas, int consultas){
+    Vert *G = NULL;
+    GrafoCompacto gc;
+    int ordem;
+    int *dist, *pai;
+    char *cor;
+    char origem[MAX_CHARS], destino[MAX_CHARS];
+    clock_t t;
+    double tLista = 0, tCompacto = 0;
+
+    geraGrafoGrade(&G, &ordem, linhas, colunas, 2 * consultas, 42);
+    reordenaGrafo(&G, ordem, NULL); /*ids proximos deixam os deltas curtos*/
+    criaGrafoCompacto(G, ordem, &gc);
+    relatorioMemoria(G, ordem, &gc);
+
+    dist = (int*) malloc(sizeof(int) * ordem);
+    pai = (int*) malloc(sizeof(int) * ordem);
+    cor = (char*) malloc(ordem);
+    for(int q = 0; q < consultas; q++){
+        int a, b;
+        sprintf(origem, "Local %d", 2 * q);
+        sprintf(destino, "Local %d", 2 * q + 1);
+        t = clock();
+        a = dijkstra(G, ordem, origem, destino);
+        tLista += clock() - t;
+        t = clock();
+        b = dijkstraCompacto(&gc, origem, destino, dist, pai, cor);
+        tCompacto += clock() - t;
+        if (abs(a) != abs(b)) printf("Distancia divergente na consulta %d\n", q);
+    }
+    printf("dijkstra() listas:   %.3fms/consulta\n", 1000.0 * tLista / CLOCKS_PER_SEC / consultas);
+    printf("dijkstra() compacto: %.3fms/consulta\n", 1000.0 * tCompacto / CLOCKS_PER_SEC / consultas);
+    free(dist);
+    free(pai);
+    free(cor);
+    destroiGrafoCompacto(&gc);
+    destroiGrafo(&G, ordem);
+}
+
+
+/* Contexto de busca reaproveitado por todas as buscas de desvio (spur) do
+   algoritmo de Yen: vetores alocados uma vez, vertices e arestas removidos
+   e as arestas virtuais das localidades de origem e destino. */
+typedef struct {
+	Vert *G;
+	int ordem;
+	int origem, destino;   /* vertices virtuais: ordem e ordem+1 */
+	int *dist, *pai;
+	char *cor;
+	char *bloqueado;       /* vertices da raiz do caminho */
+	int *arestas;          /* pares (menor, maior) removidos no desvio corrente */
+	int nArestas, capArestas;
+	const Aresta *fixas[4];/* celulas das arestas das localidades, nunca percorridas */
+	int o1, o2, do1, do2;  /* origem -> o1 (do1) e origem -> o2 (do2) */
+	int d1, d2, dd1, dd2;  /* d1 -> destino (dd1) e d2 -> destino (dd2) */
+	int direta;            /* origem -> destino na mesma aresta, ou -1 */
+} ContextoCaminhos;
+
+/* Estado do gerador de caminhos de Yen: A = caminhos ja devolvidos, B = candidatos */
+typedef struct {
+	ContextoCaminhos ctx;
+	Caminho *A, *B;
+	int nA, capA, nB, capB;
+} GeradorYen;
+
+void liberaCaminho(Caminho *c){
+    free(c->v);
+    free(c->acum);
+    c->v = c->acum = NULL;
+    c->n = 0;
+}
+
+/*Aresta (a, b) removida da busca corrente?*/
+int arestaBloqueada(const ContextoCaminhos *ctx, int a, int b){
+    int menor = a < b ? a : b, maior = a < b ? b : a;
+    for(int i = 0; i < ctx->nArestas; i++){
+        if (ctx->arestas[2*i] == menor && ctx->arestas[2*i+1] == maior) return 1;
+    }
+    return 0;
+}
+
+/*Os caminhos sao sequencias de vertices: remover (a, b) no desvio remove
+  tambem as arestas paralelas entre a e b, que dariam o mesmo caminho*/
+void bloqueiaAresta(ContextoCaminhos *ctx, int a, int b){
+    ctx->arestas = (int*) garanteCapacidade(ctx->arestas, &ctx->capArestas, 2 * (ctx->nArestas + 1), sizeof(int));
+    ctx->arestas[2*ctx->nArestas] = a < b ? a : b;
+    ctx->arestas[2*ctx->nArestas+1] = a < b ? b : a;
+    ctx->nArestas++;
+}
+
+/*Celula a e uma das arestas das localidades de origem ou destino?*/
+int arestaFixa(const ContextoCaminhos *ctx, const Aresta *a){
+    for(int i = 0; i < 4; i++){
+        if (ctx->fixas[i] == a) return 1;
+    }
+    return 0;
+}
+
+/*Celula simetrica de a, na lista de a->extremo2 voltando para v*/
+Aresta *arestaSimetrica(Vert G[], const Aresta *a, int v){
+    for(Aresta *b = G[a->extremo2].prim; b != NULL; b = b->prox){
+        if (b->extremo2 == v && b->dist_prox == a->dist_prox &&
+            strcmp(b->localidade.nome, a->localidade.nome) == 0) return b;
+    }
+    return NULL;
+}
+
+/*Aresta mais curta de u para w que nao e de localidade (a primeira da
+  lista em caso de empate), ou NULL*/
+Aresta *menorArestaLivre(const ContextoCaminhos *ctx, int u, int w){
+    Aresta *menor = NULL;
+
+    for(Aresta *aux = ctx->G[u].prim; aux != NULL; aux = aux->prox){
+        if (aux->extremo2 == w && !arestaFixa(ctx, aux) &&
+            (menor == NULL || aux->dist_prox < menor->dist_prox)) menor = aux;
+    }
+    return menor;
+}
+
+/*Relaxa a aresta u -> w de peso dado, respeitando as remocoes*/
+void relaxaContexto(ContextoCaminhos *ctx, int u, int w, int peso){
+    if (ctx->bloqueado[w] || ctx->cor[w] == PRETO || w == ctx->origem) return;
+    if (ctx->nArestas > 0 && arestaBloqueada(ctx, u, w)) return;
+    if (ctx->dist[w] > ctx->dist[u] + peso){
+        ctx->dist[w] = ctx->dist[u] + peso;
+        ctx->pai[w] = u;
+    }
+}
+
+/*Dijkstra do vertice inicio ate o destino virtual no contexto, com a mesma
+  selecao linear do menor vertice de dijkstra(); para ao fechar o destino.
+  Retorna a distancia ou INT_MAX*/
+int dijkstraContexto(ContextoCaminhos *ctx, int inicio){
+    int nVertices = ctx->ordem + 2;
+
+    for(int i = 0; i < nVertices; i++){
+        ctx->dist[i] = INT_MAX;
+        ctx->pai[i] = -1;
+        ctx->cor[i] = BRANCO;
+    }
+    ctx->dist[inicio] = 0;
+
+    for(;;){
+        int u = -1, menor = INT_MAX;
+        Aresta *aux;
+        for(int i = 1; i < nVertices; i++){
+            if (ctx->cor[i] != PRETO && ctx->dist[i] < menor){
+                menor = ctx->dist[i];
+                u = i;
+            }
+        }
+        if (u == -1 || u == ctx->destino) break;
+        ctx->cor[u] = PRETO;
+
+        if (u == ctx->origem){
+            relaxaContexto(ctx, u, ctx->o1, ctx->do1);
+            relaxaContexto(ctx, u, ctx->o2, ctx->do2);
+            if (ctx->direta >= 0) relaxaContexto(ctx, u, ctx->destino, ctx->direta);
+            continue;
+        }
+        for(aux = ctx->G[u].prim; aux != NULL; aux = aux->prox){
+            if (!arestaFixa(ctx, aux)) relaxaContexto(ctx, u, aux->extremo2, aux->dist_prox);
+        }
+        if (u == ctx->d1) relaxaContexto(ctx, u, ctx->destino, ctx->dd1);
+        if (u == ctx->d2) relaxaContexto(ctx, u, ctx->destino, ctx->dd2);
+    }
+    return ctx->dist[ctx->destino];
+}
+
+/*Monta o caminho raiz[0..nRaiz-1] + caminho do contexto (de raiz[nRaiz-1]
+  ate o destino, pelos pais). acumRaiz[] tem as distancias da raiz*/
+void montaCaminho(const ContextoCaminhos *ctx, const int raiz[], const int acumRaiz[], int nRaiz, Caminho *c){
+    int n = 0;
+
+    for(int v = ctx->destino; v != raiz[nRaiz-1]; v = ctx->pai[v]) n++;
+    c->n = nRaiz + n;
+    c->v = (int*) malloc(sizeof(int) * c->n);
+    c->acum = (int*) malloc(sizeof(int) * c->n);
+    if (c->v == NULL || c->acum == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(c->v, raiz, sizeof(int) * nRaiz);
+    memcpy(c->acum, acumRaiz, sizeof(int) * nRaiz);
+    for(int v = ctx->destino, i = c->n - 1; v != raiz[nRaiz-1]; v = ctx->pai[v], i--){
+        c->v[i] = v;
+        c->acum[i] = acumRaiz[nRaiz-1] + ctx->dist[v];
+    }
+    c->custo = c->acum[c->n - 1];
+}
+
+/*Prepara o gerador de caminhos entre duas localidades. Retorna 0 se alguma
+  localidade nao existe*/
+int iniciaGeradorYen(GeradorYen *y, Vert G[], int ordem, char *origem, char *destino){
+    ContextoCaminhos *ctx = &y->ctx;
+    int nVertices = ordem + 2;
+    Aresta *arestaOrigem, *arestaDestino;
+
+    memset(y, 0, sizeof(GeradorYen));
+    arestaOrigem = localizaLocalidade(G, ordem, origem, &ctx->o1, &ctx->o2, &ctx->do1, &ctx->do2);
+    arestaDestino = localizaLocalidade(G, ordem, destino, &ctx->d1, &ctx->d2, &ctx->dd1, &ctx->dd2);
+    if (arestaOrigem == NULL || arestaDestino == NULL) return 0;
+    ctx->G = G;
+    ctx->ordem = ordem;
+    ctx->origem = ordem;
+    ctx->destino = ordem + 1;
+    ctx->direta = -1;
+    /*cada aresta guarda uma unica localidade: mesma celula so quando
+      origem e destino sao a mesma localidade*/
+    if (arestaOrigem == arestaDestino) ctx->direta = abs(ctx->do1 - ctx->dd1);
+    /*as arestas das localidades so sao percorridas pelas ligacoes virtuais:
+      atravessa-las inteiras passaria de novo pela origem ou pelo destino.
+      Sao removidas pela celula (nos dois sentidos), nao pelo par de
+      vertices, para manter as arestas paralelas*/
+    ctx->fixas[0] = arestaOrigem;
+    ctx->fixas[1] = arestaSimetrica(G, arestaOrigem, ctx->o1);
+    ctx->fixas[2] = arestaDestino;
+    ctx->fixas[3] = arestaSimetrica(G, arestaDestino, ctx->d1);
+
+    ctx->dist = (int*) malloc(sizeof(int) * nVertices);
+    ctx->pai = (int*) malloc(sizeof(int) * nVertices);
+    ctx->cor = (char*) malloc(nVertices);
+    ctx->bloqueado = (char*) calloc(nVertices, 1);
+    if (ctx->dist == NULL || ctx->pai == NULL || ctx->cor == NULL || ctx->bloqueado == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    return 1;
+}
+
+void liberaGeradorYen(GeradorYen *y){
+    for(int i = 0; i < y->nA; i++) liberaCaminho(&y->A[i]);
+    for(int i = 0; i < y->nB; i++) liberaCaminho(&y->B[i]);
+    free(y->A);
+    free(y->B);
+    free(y->ctx.dist);
+    free(y->ctx.pai);
+    free(y->ctx.cor);
+    free(y->ctx.bloqueado);
+    free(y->ctx.arestas);
+}
+
+int caminhosIguais(const Caminho *a, const Caminho *b){
+    return a->n == b->n && memcmp(a->v, b->v, sizeof(int) * a->n) == 0;
+}
+
+/*Proximo caminho sem repeticao de vertices em ordem crescente de distancia
+  (algoritmo de Yen). Copia o caminho para *saida (liberar com
+  liberaCaminho) e retorna 1, ou retorna 0 quando nao ha mais caminhos*/
+int proximoCaminhoYen(GeradorYen *y, Caminho *saida){
+    ContextoCaminhos *ctx = &y->ctx;
+    int melhor = 0;
+
+    if (y->nA == 0){
+        Caminho c;
+        int raiz = ctx->origem, zero = 0;
+        if (dijkstraContexto(ctx, ctx->origem) == INT_MAX) return 0;
+        montaCaminho(ctx, &raiz, &zero, 1, &c);
+        y->A = (Caminho*) garanteCapacidade(y->A, &y->capA, 1, sizeof(Caminho));
+        y->A[y->nA++] = c;
+    } else {
+        const Caminho *anterior = &y->A[y->nA - 1];
+        for(int i = 0; i < anterior->n - 1; i++){
+            int desvio = anterior->v[i];
+            Caminho c;
+            int repetido = 0;
+
+            /*remove a proxima aresta de todo caminho ja aceito com a mesma raiz*/
+            ctx->nArestas = 0;
+            for(int a = 0; a < y->nA; a++){
+                if (y->A[a].n > i + 1 && memcmp(y->A[a].v, anterior->v, sizeof(int) * (i + 1)) == 0){
+                    bloqueiaAresta(ctx, y->A[a].v[i], y->A[a].v[i+1]);
+                }
+            }
+            /*remove os vertices da raiz, exceto o vertice de desvio*/
+            for(int r = 0; r < i; r++) ctx->bloqueado[anterior->v[r]] = 1;
+            if (dijkstraContexto(ctx, desvio) != INT_MAX){
+                montaCaminho(ctx, anterior->v, anterior->acum, i + 1, &c);
+                for(int b = 0; b < y->nB && !repetido; b++) repetido = caminhosIguais(&c, &y->B[b]);
+                if (repetido){
+                    liberaCaminho(&c);
+                } else {
+                    y->B = (Caminho*) garanteCapacidade(y->B, &y->capB, y->nB + 1, sizeof(Caminho));
+                    y->B[y->nB++] = c;
+                }
+            }
+            for(int r = 0; r < i; r++) ctx->bloqueado[anterior->v[r]] = 0;
+        }
+        ctx->nArestas = 0;
+        if (y->nB == 0) return 0;
+
+        /*move o candidato mais curto (menos vertices no empate) de B para A*/
+        for(int b = 1; b < y->nB; b++){
+            if (y->B[b].custo < y->B[melhor].custo ||
+                (y->B[b].custo == y->B[melhor].custo && y->B[b].n < y->B[melhor].n)) melhor = b;
+        }
+        y->A = (Caminho*) garanteCapacidade(y->A, &y->capA, y->nA + 1, sizeof(Caminho));
+        y->A[y->nA++] = y->B[melhor];
+        y->B[melhor] = y->B[--y->nB];
+    }
+
+    {
+        const Caminho *c = &y->A[y->nA - 1];
+        saida->n = c->n;
+        saida->custo = c->custo;
+        saida->v = (int*) malloc(sizeof(int) * c->n);
+        saida->acum = (int*) malloc(sizeof(int) * c->n);
+        if (saida->v == NULL || saida->acum == NULL){
+            fprintf(stderr, "Erro de alocacao\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(saida->v, c->v, sizeof(int) * c->n);
+        memcpy(saida->acum, c->acum, sizeof(int) * c->n);
+    }
+    return 1;
+}
+
+/*Os k caminhos sem repeticao de vertices mais curtos entre duas localidades.
+  Preenche caminhos[] e retorna quantos existem (ate k)*/
+int kCaminhosMaisCurtos(Vert G[], int ordem, char *origem, char *destino, int k, Caminho caminhos[]){
+    GeradorYen y;
+    int n = 0;
+
+    if (!iniciaGeradorYen(&y, G, ordem, origem, destino)) return 0;
+    while(n < k && proximoCaminhoYen(&y, &caminhos[n])) n++;
+    liberaGeradorYen(&y);
+    return n;
+}
+
+/* Estado da enumeracao exaustiva usada para conferir o algoritmo de Yen */
+typedef struct {
+	ContextoCaminhos *ctx;
+	int *h;          /* h[v] = distancia minima de v ate o destino (poda) */
+	char *visitado;
+	int *melhores;   /* k menores custos encontrados, em ordem crescente */
+	int k, n;
+} EnumeracaoCaminhos;
+
+void visitaEnumeracao(EnumeracaoCaminhos *e, int u, int w, int peso, int custo);
+
+/*Percorre todos os caminhos simples a partir de u, com as mesmas arestas
+  (reais e virtuais) de dijkstraContexto(), podando pelos k melhores custos.
+  Entre arestas paralelas so a mais curta conta, como nos caminhos de Yen*/
+void enumeraCaminhos(EnumeracaoCaminhos *e, int u, int custo){
+    ContextoCaminhos *ctx = e->ctx;
+    Aresta *aux;
+
+    if (e->h[u] == INT_MAX) return;
+    if (e->n == e->k && custo + e->h[u] >= e->melhores[e->k-1]) return;
+    if (u == ctx->destino){
+        int i = (e->n < e->k) ? e->n++ : e->k - 1;
+        while(i > 0 && e->melhores[i-1] > custo){
+            e->melhores[i] = e->melhores[i-1];
+            i--;
+        }
+        e->melhores[i] = custo;
+        return;
+    }
+    e->visitado[u] = 1;
+    if (u == ctx->origem){
+        visitaEnumeracao(e, u, ctx->o1, ctx->do1, custo);
+        visitaEnumeracao(e, u, ctx->o2, ctx->do2, custo);
+        if (ctx->direta >= 0) visitaEnumeracao(e, u, ctx->destino, ctx->direta, custo);
+    } else {
+        for(aux = ctx->G[u].prim; aux != NULL; aux = aux->prox){
+            if (aux == menorArestaLivre(ctx, u, aux->extremo2)){
+                visitaEnumeracao(e, u, aux->extremo2, aux->dist_prox, custo);
+            }
+        }
+        if (u == ctx->d1) visitaEnumeracao(e, u, ctx->destino, ctx->dd1, custo);
+        if (u == ctx->d2) visitaEnumeracao(e, u, ctx->destino, ctx->dd2, custo);
+    }
+    e->visitado[u] = 0;
+}
+
+void visitaEnumeracao(EnumeracaoCaminhos *e, int u, int w, int peso, int custo){
+    if (e->visitado[w] || w == e->ctx->origem) return;
+    enumeraCaminhos(e, w, custo + peso);
+}
+
+/*Confere os k primeiros caminhos de Yen entre duas localidades contra a
+  enumeracao exaustiva de caminhos simples: mesmos custos, nenhum vertice
+  repetido e cada trecho entre vertices reais feito por uma aresta existente
+  que nao e de localidade. Retorna 1 se ok*/
+int confereKCaminhos(Vert G[], int ordem, char *origem, char *destino, int k){
+    GeradorYen y;
+    EnumeracaoCaminhos e;
+    ContextoCaminhos *ctx = &y.ctx;
+    int nVertices = ordem + 2, n = 0, ok = 1;
+    Caminho c;
+
+    if (!iniciaGeradorYen(&y, G, ordem, origem, destino)) return 0;
+    e.ctx = ctx;
+    e.k = k;
+    e.n = 0;
+    e.h = (int*) malloc(sizeof(int) * nVertices);
+    e.visitado = (char*) calloc(nVertices, 1);
+    e.melhores = (int*) malloc(sizeof(int) * k);
+    if (e.h == NULL || e.visitado == NULL || e.melhores == NULL){
+        fprintf(stderr, "Erro de alocacao\n");
+        exit(EXIT_FAILURE);
+    }
+    for(int v = 1; v < nVertices; v++) e.h[v] = dijkstraContexto(ctx, v);
+    e.h[0] = INT_MAX;
+    enumeraCaminhos(&e, ctx->origem, 0);
+
+    while(n < k && proximoCaminhoYen(&y, &c)){
+        char *repetido = (char*) calloc(nVertices, 1);
+        if (n >= e.n || c.custo != e.melhores[n]){
+            printf("%s ate %s: caminho %d com %dm, enumeracao %dm\n", origem, destino, n + 1,
+                   c.custo, n < e.n ? e.melhores[n] : -1);
+            ok = 0;
+        }
+        for(int i = 0; i < c.n; i++){
+            if (repetido[c.v[i]]){
+                printf("%s ate %s: caminho %d passa duas vezes pelo mesmo ponto\n", origem, destino, n + 1);
+                ok = 0;
+                break;
+            }
+            repetido[c.v[i]] = 1;
+            if (i > 0 && c.v[i-1] < ordem && c.v[i] < ordem){
+                Aresta *a = menorArestaLivre(ctx, c.v[i-1], c.v[i]);
+                if (a == NULL || a->dist_prox != c.acum[i] - c.acum[i-1]){
+                    printf("%s ate %s: caminho %d usa aresta inexistente ou de localidade\n", origem, destino, n + 1);
+                    ok = 0;
+                    break;
+                }
+            }
+        }
+        free(repetido);
+        liberaCaminho(&c);
+        n++;
+    }
+    if (n != e.n){
+        printf("%s ate %s: %d caminhos de Yen, %d na enumeracao\n", origem, destino, n, e.n);
+        ok = 0;
+    }
+    free(e.h);
+    free(e.visitado);
+    free(e.melhores);
+    liberaGeradorYen(&y);
+    return ok;
+}
+
+
+/*Fracao dos metros de a percorrida em arestas que tambem estao em b*/
+double sobreposicaoCaminhos(const Caminho *a, const Caminho *b){
+    int comum = 0;
+
+    if (a->custo == 0) return 1.0;
+    for(int i = 0; i < a->n - 1; i++){
+        for(int j = 0; j < b->n - 1; j++){
+            if ((a->v[i] == b->v[j] && a->v[i+1] == b->v[j+1]) ||
+                (a->v[i] == b->v[j+1] && a->v[i+1] == b->v[j])){
+                comum += a->acum[i+1] - a->acum[i];
+                break;
+            }
+        }
+    }
+    return (double) comum / a->custo;
+}
+
+/*Ate nRotas rotas alternativas entre duas localidades: percorre os caminhos
+  de Yen em ordem de distancia e aceita os que compartilham no maximo
+  sobreposicaoMax (0..1) dos seus metros com cada rota ja aceita. Examina no
+  maximo CANDIDATOS_POR_ALTERNATIVA * nRotas caminhos. Retorna quantas rotas*/
+int rotasAlternativas(Vert G[], int ordem, char *origem, char *destino, int nRotas,
+                      double sobreposicaoMax, Caminho rotas[]){
+    GeradorYen y;
+    Caminho c;
+    int n = 0;
+
+    if (!iniciaGeradorYen(&y, G, ordem, origem, destino)) return 0;
+    for(int examinados = 0; n < nRotas && examinados < CANDIDATOS_POR_ALTERNATIVA * nRotas &&
+                            proximoCaminhoYen(&y, &c); examinados++){
+        int aceita = 1;
+        for(int r = 0; r < n && aceita; r++) aceita = sobreposicaoCaminhos(&c, &rotas[r]) <= sobreposicaoMax;
+        if (aceita) rotas[n++] = c;
+        else liberaCaminho(&c);
+    }
+    liberaGeradorYen(&y);
+    return n;
+}
+
+/*Imprime as rotas alternativas entre duas localidades com os ids dos vertices*/
+void imprimeRotasAlternativas(Vert G[], int ordem, char *origem, char *destino, int nRotas, double sobreposicaoMax){
+    Caminho rotas[nRotas];
+    int n = rotasAlternativas(G, ordem, origem, destino, nRotas, sobreposicaoMax, rotas);
+
+    printf("Rotas alternativas de %s ate %s (sobreposicao maxima %.0f%%)\n", origem, destino, 100 * sobreposicaoMax);
+    for(int r = 0; r < n; r++){
+        printf("Rota %d (%dm): %s", r + 1, rotas[r].custo, origem);
+        for(int i = 1; i < rotas[r].n - 1; i++) printf(" -> %d", G[rotas[r].v[i]].id);
+        printf(" -> %s\n", destino);
+        liberaCaminho(&rotas[r]);
+    }
+}
+
+/*Tempo de cada caminho extra do algoritmo de Yen em uma grade*/
+void benchmarkKCaminhos(int linhas, int colunas, int k){
+    Vert *G = NULL;
+    GeradorYen y;
+    Caminho c;
+    int ordem;
+    clock_t t, t0;
+
+    geraGrafoGrade(&G, &ordem, linhas, colunas, 1, 42);
+    reordenaGrafo(&G, ordem, NULL);
+    if (!iniciaGeradorYen(&y, G, ordem, "Minha Casa", "Local 0")){
+        destroiGrafo(&G, ordem);
+        return;
+    }
+    printf("Yen em grade %dx%d (Minha Casa ate Local 0)\n", linhas, colunas);
+    t0 = clock();
+    for(int i = 1; i <= k; i++){
+        t = clock();
+        if (!proximoCaminhoYen(&y, &c)) break;
+        printf("Caminho %2d: %5dm, %3d vertices, %.3fs (acumulado %.3fs)\n", i, c.custo, c.n - 2,
+               (double)(clock() - t) / CLOCKS_PER_SEC, (double)(clock() - t0) / CLOCKS_PER_SEC);
+        liberaCaminho(&c);
+    }
+    liberaGeradorYen(&y);
+    destroiGrafo(&G, ordem);
+}
+
+
+int main(){
+	Vert *G = NULL;
+	int ordem = 51;
+	constroiGrafo(&G, &ordem);
+
+	/*vetor de localidades utilizadas no algoritmo. Altere as localidades para obter outras rotas*/
+	char *locais[] = {"Pizza","Mambo","Shopping Patio Higienopolis"};
+	int n = sizeof(locais) / sizeof(locais[0]);
+
+	/*corrige acentos, maiusculas e erros de digitacao nos nomes informados*/
+	IndiceLocalidades *indice = criaIndiceLocalidades();
+	indexaLocalidades(indice, G, ordem);
+	for(int i = 0; i < n; i++){
+		char *nome = resolveLocalidade(indice, locais[i]);
+		if (nome == NULL){
+			fprintf(stderr, "Localidade nao encontrada: %s\n", locais[i]);
+			exit(EXIT_FAILURE);
+		}
+		if (strcmp(nome, locais[i]) != 0){
+			printf("Localidade \"%s\" interpretada como \"%s\"\n", locais[i], nome);
+		}
+		locais[i] = nome;
+	}
+	if (n <= LIMITE_FORCA_BRUTA){
+		melhorRota(G, ordem, locais, n);
+	} else {
+		melhorRotaBB(G, ordem, locais, n, 0, 0);
+	}
+	/*melhorRotaVeiculos(G, ordem, locais, n, 2);*/
+	/*imprimeGrafo(G,ordem);*/
+	/*relatorioMemoria(G, ordem, NULL);*/
+	/*imprimeRotasAlternativas(G, ordem, "Minha Casa", locais[0], 3, 0.5);*/
+	destroiIndiceLocalidades(&indice);
+	destroiGrafo(&G, ordem);
+
+#ifdef BENCHMARK
+	/*compilar com -DBENCHMARK para medir o desempenho em grafos maiores*/
+	printf("\n");
+	{
+		char *reais[] = {"Oxxo","Bluefit Maria Antonia","Estacao higienopolis Mackenzie",
+		                 "SESC Consolacao","Farmacia","Pao de acucar","Santa Casa","Palacete","Mambo",
+		                 "Shopping Patio Higienopolis","Posto de Gasolina","Padaria",
+		                 "Universidade Persbiteriana Mackenzie","Parque buenos aires","Pao de acucar 2",
+		                 "Pizza","Hospital Infantil Sabara"};
+		constroiGrafo(&G, &ordem);
+		benchmarkBranchAndBound(G, ordem, reais, sizeof(reais) / sizeof(reais[0]), 30, 60);
+		destroiGrafo(&G, ordem);
+	}
+	printf("\n");
+	benchmarkReordenacao(100, 100, 10);
+	{
+		char *paradas[] = {"Oxxo","Farmacia","Santa Casa","Palacete","Mambo","Padaria",
+		                   "Posto de Gasolina","Pizza","Hospital Infantil Sabara","SESC Consolacao"};
+		constroiGrafo(&G, &ordem);
+		printf("\n");
+		benchmarkJanelas(G, ordem, paradas, sizeof(paradas) / sizeof(paradas[0]));
+		destroiGrafo(&G, ordem);
+	}
+	printf("\n");
+	benchmarkVeiculos(30, 30, 300, 4);
+	printf("\n");
+	benchmarkIndiceLocalidades(1000000, 1000);
+	printf("\n");
+	benchmarkGrafoCompacto(100, 100, 10);
+	printf("\n");
+	benchmarkKCaminhos(60, 60, 20);
+	{
+		char *todos[] = {"Minha Casa","Oxxo","Bluefit Maria Antonia","Estacao higienopolis Mackenzie",
+		                 "SESC Consolacao","Farmacia","Pao de acucar","Santa Casa","Palacete","Mambo",
+		                 "Shopping Patio Higienopolis","Posto de Gasolina","Padaria",
+		                 "Universidade Persbiteriana Mackenzie","Parque buenos aires","Pao de acucar 2",
+		                 "Pizza","Hospital Infantil Sabara"};
+		int nTodos = sizeof(todos) / sizeof(todos[0]), pares = 0, certos = 0;
+		constroiGrafo(&G, &ordem);
+		for(int a = 0; a < nTodos; a++){
+			for(int b = 0; b < nTodos; b++){
+				if (a == b) continue;
+				pares++;
+				certos += confereKCaminhos(G, ordem, todos[a], todos[b], 6);
+			}
+		}
+		printf("Yen x enumeracao exaustiva (k = 6): %d/%d pares iguais\n", certos, pares);
+
+		/*aresta paralela a de "Minha Casa" (26-33) com outra localidade*/
+		acrescentaAresta(G, ordem, 26, 33, 300, "Estacionamento", 200, 100);
+		{
+			Caminho c;
+			int esperado = abs(dijkstra(G, ordem, "Minha Casa", "Estacionamento"));
+			int n = kCaminhosMaisCurtos(G, ordem, "Minha Casa", "Estacionamento", 1, &c);
+			printf("Aresta paralela: dijkstra %dm, 1o caminho de Yen %dm\n", esperado, n == 1 ? c.custo : -1);
+			if (n == 1) liberaCaminho(&c);
+		}
+		pares = certos = 0;
+		for(int a = 0; a < nTodos; a++){
+			pares += 2;
+			certos += confereKCaminhos(G, ordem, todos[a], "Estacionamento", 6);
+			certos += confereKCaminhos(G, ordem, "Estacionamento", todos[a], 6);
+		}
+		printf("Com a aresta paralela: %d/%d pares iguais\n", certos, pares);
+		destroiGrafo(&G, ordem);
+	}
+#endif
 	return 0;
 }